@@ -0,0 +1,115 @@
+//=======================================================
+// Arquivo: app_mp3.c
+// Descrição: Gera o mapa de notas (notes.txt e, com
+// --bin, o mapa compilado notes.ghc) a partir de um
+// arquivo MP3.
+//=======================================================
+
+#include "mapeamento_audio.h"
+#include "mapeamento_lote.h"
+#include "mapa_compilado.h"
+#include <string.h>
+
+#define OUTPUT_FILENAME "notes.txt"
+#define COMPILED_FILENAME "notes.ghc"
+
+int main(int argc, char** argv) {
+    const char* arquivo_mp3 = NULL;
+    const char* lote = NULL;
+    AnalysisOptions options = ANALYSIS_OPTIONS_DEFAULT;
+    int compilar = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stream") == 0) {
+            options.mode = ANALYSIS_STREAMING;
+        } else if ((strcmp(argv[i], "--threads") == 0 || strcmp(argv[i], "-t") == 0) && i + 1 < argc) {
+            options.num_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--decimar") == 0) {
+            options.decimate = 1;
+        } else if (strcmp(argv[i], "--float") == 0) {
+            options.float_decode = 1;
+        } else if (strcmp(argv[i], "--mdct") == 0) {
+            options.engine = ANALYSIS_ENGINE_MDCT;
+        } else if (strcmp(argv[i], "--goertzel") == 0) {
+            options.engine = ANALYSIS_ENGINE_GOERTZEL;
+        } else if (strcmp(argv[i], "--sdft") == 0) {
+            options.engine = ANALYSIS_ENGINE_SDFT;
+        } else if (strcmp(argv[i], "--inicio") == 0 && i + 1 < argc) {
+            options.start_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--fim") == 0 && i + 1 < argc) {
+            options.end_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--hop") == 0 && i + 1 < argc) {
+            options.hop_size = atoi(argv[++i]);
+            if (options.hop_size < 1 || options.hop_size > FRAME_SIZE) {
+                printf("Hop invalido: use um valor entre 1 e %d amostras.\n", FRAME_SIZE);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            if (window_type_from_name(argv[++i], &options.window) != 0) {
+                printf("Janela desconhecida '%s': use hann, blackman ou rect.\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            lote = argv[++i];
+        } else if (strcmp(argv[i], "--bin") == 0) {
+            compilar = 1;
+        } else if (strcmp(argv[i], "--compile") == 0 && i + 2 < argc) {
+            // Importa um mapa em texto (editado a mao, por exemplo) para o formato compilado
+            return chart_compile_text(argv[i + 1], argv[i + 2]) == 0 ? 0 : -1;
+        } else if (strcmp(argv[i], "--export") == 0 && i + 2 < argc) {
+            return chart_export_text(argv[i + 1], argv[i + 2]) == 0 ? 0 : -1;
+        } else {
+            arquivo_mp3 = argv[i];
+        }
+    }
+
+    int trecho = options.start_seconds > 0 || options.end_seconds > 0;
+    if (trecho && (options.start_seconds < 0 || (options.end_seconds > 0 && options.end_seconds <= options.start_seconds))) {
+        printf("Trecho invalido: use 0 <= --inicio < --fim (segundos).\n");
+        return -1;
+    }
+    if (trecho && (lote || options.decimate || options.float_decode || options.engine == ANALYSIS_ENGINE_MDCT)) {
+        printf("--inicio/--fim so valem para uma musica, com a FFT sobre o PCM (sem --decimar, --float ou --mdct).\n");
+        return -1;
+    }
+    if (lote && (options.decimate || options.float_decode || options.engine == ANALYSIS_ENGINE_MDCT)) {
+        printf("--batch mapeia cada musica a partir do PCM int16 (sem --decimar, --float ou --mdct).\n");
+        return -1;
+    }
+
+    if (lote) {
+        // Em lote, cada thread mapeia musicas inteiras
+        return analyze_mp3_batch(lote, &options) == 0 ? 0 : -1;
+    }
+
+    if (!arquivo_mp3) {
+        printf("Uso: %s <arquivo.mp3> [--stream] [--threads N] [--hop N] [--window tipo] [--inicio S] [--fim S] [--decimar|--float|--mdct|--goertzel|--sdft] [--bin]\n", argv[0]);
+        printf("     %s --batch <pasta|lista.txt> [--threads N] [--hop N] [--window tipo]\n", argv[0]);
+        printf("     %s --compile <notes.txt> <notes.ghc>\n", argv[0]);
+        printf("     %s --export <notes.ghc> <notes.txt>\n", argv[0]);
+        printf("  --stream      analisa o MP3 em streaming, com memoria limitada\n");
+        printf("  --threads N   divide a decodificacao e os frames da FFT entre N threads (modo em memoria)\n");
+        printf("  --hop N       avanca N amostras entre janelas da FFT (padrao %d, sem sobreposicao)\n", FRAME_SIZE);
+        printf("  --window tipo janela da STFT: rect (padrao), hann ou blackman\n");
+        printf("  --inicio S    mapeia a partir de S segundos, decodificando so os frames do trecho\n");
+        printf("  --fim S       mapeia ate S segundos (o indice de frames fica salvo em <musica>.mp3.idx)\n");
+        printf("  --decimar     analisa uma copia mono filtrada a ~5 kHz: FFT e PCM ~8x menores\n");
+        printf("  --float       decodifica direto para float mono, sem passar por int16\n");
+        printf("  --mdct        experimental: notas das linhas MDCT do MP3, sem PCM nem FFT\n");
+        printf("  --goertzel    no lugar da FFT, calcula so os bins das notas (banco de Goertzel)\n");
+        printf("  --sdft        idem com uma DFT deslizante: cada janela custa so o hop (bom com --hop pequeno)\n");
+        printf("  --batch       mapeia todas as musicas da pasta/lista, gerando <musica>.notes.txt\n");
+        printf("  --bin         grava tambem o mapa compilado %s, que o jogo carrega via mmap\n", COMPILED_FILENAME);
+        printf("  --compile     converte um mapa em texto para o formato compilado\n");
+        printf("  --export      converte um mapa compilado de volta para texto\n");
+        return -1;
+    }
+
+    if (analyze_mp3_to_file(arquivo_mp3, OUTPUT_FILENAME, &options) != 0) return -1;
+    if (compilar) {
+        // Compila a partir do texto recem-gravado: o jogo le os mesmos tempos dos dois formatos
+        if (chart_compile_text(OUTPUT_FILENAME, COMPILED_FILENAME) != 0) return -1;
+        printf("Mapa compilado salvo em '%s'!\n", COMPILED_FILENAME);
+    }
+    return 0;
+}
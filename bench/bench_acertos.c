@@ -0,0 +1,106 @@
+//=======================================================
+// Arquivo: bench_acertos.c
+// Descrição: Custo de julgar um toque (check_hits) perto
+// do fim de mapas de 1 mil a 100 mil notas: o laço
+// original, que varre level_notes desde o indice 0
+// pulando as notas ja processadas, contra as filas por
+// pista com cursor do fila_pistas.c. Metade dos toques
+// acerta a nota da vez e metade cai numa pista errada.
+// Confere se os dois acertam as mesmas notas.
+//=======================================================
+
+#include "fila_pistas.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_PRESSES 2000     // toques medidos, no fim do mapa
+#define BENCH_SPACING 0.08f    // s entre notas: um mapa denso
+#define BENCH_WINDOW 0.2
+
+typedef struct {
+    float timestamp;
+    int note_index;
+    int foi_processada;
+    int foi_pressionada;
+} Note;
+
+// O laço original de check_hits (botoes 1..4 sao as pistas 0..3)
+static int hit_linear(Note* notes, int count, int pista, double t) {
+    for (int i = 0; i < count; i++) {
+        if (notes[i].foi_processada) continue;
+        if (pista == notes[i].note_index + 1 &&
+            t > notes[i].timestamp - BENCH_WINDOW && t < notes[i].timestamp + BENCH_WINDOW) {
+            notes[i].foi_processada = 1;
+            notes[i].foi_pressionada = 1;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Toque k: na nota k / 2 mais um pouco; os impares vao para a pista seguinte
+static void press(const Note* notes, int first, int k, int* pista, double* t) {
+    const Note* note = &notes[first + k / 2];
+    *pista = (k & 1) ? (note->note_index + 1) % LANE_COUNT + 1 : note->note_index + 1;
+    *t = note->timestamp + 0.01;
+}
+
+int main(void) {
+    static const int sizes[] = { 1000, 10000, 100000 };
+
+    printf("notas,metodo,ns_por_toque,acertos,iguais\n");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int count = sizes[s];
+        Note* notes = (Note*)malloc(count * sizeof(Note));
+        int* hits_linear = (int*)malloc(BENCH_PRESSES * sizeof(int));
+        int* hits_queue = (int*)malloc(BENCH_PRESSES * sizeof(int));
+        unsigned int seed = 1;
+        for (int i = 0; i < count; i++) {
+            seed = seed * 1103515245 + 12345;
+            notes[i].timestamp = i * BENCH_SPACING;
+            notes[i].note_index = (seed >> 16) % LANE_COUNT;
+            notes[i].foi_processada = 0;
+            notes[i].foi_pressionada = 0;
+        }
+
+        // Ate o trecho medido o jogo ja julgou tudo: acertos ou notas que update_game deu por perdidas
+        int first = count - BENCH_PRESSES / 2;
+        LaneQueues queues = {0};
+        for (int i = 0; i < count; i++) lane_queues_push(&queues, notes[i].note_index, notes[i].timestamp, i);
+        for (int i = 0; i < first; i++) {
+            notes[i].foi_processada = 1;
+            lane_queues_hit(&queues, notes[i].note_index, notes[i].timestamp, BENCH_WINDOW);
+        }
+
+        int pista;
+        double t;
+        double t0 = now_seconds();
+        for (int k = 0; k < BENCH_PRESSES; k++) {
+            press(notes, first, k, &pista, &t);
+            hits_linear[k] = hit_linear(notes, count, pista, t);
+        }
+        double t_linear = now_seconds() - t0;
+
+        t0 = now_seconds();
+        for (int k = 0; k < BENCH_PRESSES; k++) {
+            press(notes, first, k, &pista, &t);
+            hits_queue[k] = lane_queues_hit(&queues, pista - 1, t, BENCH_WINDOW);
+        }
+        double t_queue = now_seconds() - t0;
+
+        int acertos = 0, iguais = 0;
+        for (int k = 0; k < BENCH_PRESSES; k++) {
+            acertos += hits_queue[k] >= 0;
+            iguais += hits_linear[k] == hits_queue[k];
+        }
+        printf("%d,laco,%.1f,%d,%d/%d\n", count, t_linear * 1e9 / BENCH_PRESSES, acertos, iguais, BENCH_PRESSES);
+        printf("%d,filas,%.1f,%d,%d/%d\n", count, t_queue * 1e9 / BENCH_PRESSES, acertos, iguais, BENCH_PRESSES);
+
+        lane_queues_free(&queues);
+        free(notes);
+        free(hits_linear);
+        free(hits_queue);
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+//=======================================================
+// Arquivo: bench_analise.c
+// Descrição: Benchmark do analisador de notas com audio
+// sintetico de gabarito conhecido. Mede a vazao de cada
+// etapa (downmix, FFT, pico, classificacao, escrita) e a
+// precisao/revocacao das notas do pipeline real, para
+// varias taxas, canais e duracoes. A saida e CSV (uma
+// linha por configuracao) para comparar entre versoes:
+//   ./bench_analise > antes.csv
+//=======================================================
+
+#include "mapeamento_audio.h"
+#include "mapa_compilado.h"
+#include "pico_espectral.h"
+#include "kiss_fftr.h"
+#include "bench_util.h"
+#include <string.h>
+
+#define BENCH_OUTPUT "bench_analise.txt"
+#define NOTE_SECONDS 0.5      // cada nota do gabarito dura meio segundo
+#define MAX_BENCH_NOTES 4096
+
+typedef struct {
+    int sample_rate;
+    int channels;
+    int seconds;
+    WindowType window;
+    int hop_size;
+} BenchConfig;
+
+static const BenchConfig configs[] = {
+    { 22050, 1, 10, WINDOW_RECTANGULAR, FRAME_SIZE },
+    { 44100, 1, 10, WINDOW_RECTANGULAR, FRAME_SIZE },
+    { 44100, 2, 10, WINDOW_RECTANGULAR, FRAME_SIZE },
+    { 48000, 2, 10, WINDOW_RECTANGULAR, FRAME_SIZE },
+    { 44100, 2, 60, WINDOW_RECTANGULAR, FRAME_SIZE },
+    { 44100, 2, 60, WINDOW_HANN, 1024 },
+    { 48000, 2, 60, WINDOW_HANN, 512 },
+};
+
+// A musica de gabarito do bench_util.h, com notas de NOTE_SECONDS
+static AudioData* make_audio(const BenchConfig* cfg, TruthNote* truth, int* truth_count) {
+    AudioData* audio = (AudioData*)malloc(sizeof(AudioData));
+    size_t frames = (size_t)cfg->seconds * cfg->sample_rate;
+    audio->pcm_buffer = (short*)malloc(frames * cfg->channels * sizeof(short));
+    audio->pcm_size = frames * cfg->channels;
+    audio->sample_rate = cfg->sample_rate;
+    audio->channels = cfg->channels;
+    bench_truth_song(audio->pcm_buffer, frames, cfg->channels, cfg->sample_rate, NOTE_SECONDS, NUM_NOTES,
+                     truth, truth_count);
+    return audio;
+}
+
+// Tempo por etapa, repetindo o que o detector faz frame a frame
+typedef struct {
+    double downmix, fft, peak, classify, write;
+    long frames;
+} StageTimes;
+
+static void time_stages(const AudioData* audio, const BenchConfig* cfg, StageTimes* st) {
+    static float window[FRAME_SIZE];
+    static kiss_fft_scalar in[FRAME_SIZE];
+    static kiss_fft_cpx out[FRAME_SIZE / 2 + 1];
+    static signed char bin_notes[FRAME_SIZE / 2];
+    kiss_fftr_cfg fft = kiss_fftr_alloc(FRAME_SIZE, 0, NULL, NULL);
+    FILE* output = fopen(BENCH_OUTPUT, "w");
+    memset(st, 0, sizeof(*st));
+
+    double t0 = now_seconds();
+    window_build(window, FRAME_SIZE, cfg->window, audio->channels);
+    st->downmix += now_seconds() - t0;
+    t0 = now_seconds();
+    build_bin_note_table(bin_notes, audio->sample_rate);
+    st->classify += now_seconds() - t0;
+
+    long window_size = FRAME_SIZE * audio->channels;
+    long step = cfg->hop_size * audio->channels;
+    int last = NOTE_NONE;
+    for (long offset = 0; offset + window_size < (long)audio->pcm_size; offset += step) {
+        double t1 = now_seconds();
+        window_apply(audio->pcm_buffer + offset, audio->channels, window, in, FRAME_SIZE);
+        double t2 = now_seconds();
+        kiss_fftr(fft, in, out);
+        double t3 = now_seconds();
+        float max_sq;
+        int max_idx = spectrum_peak(out, 1, FRAME_SIZE / 2, &max_sq);
+        double t4 = now_seconds();
+        int note = sqrtf(max_sq) > THRESHOLD ? bin_notes[max_idx] : NOTE_NONE;
+        double t5 = now_seconds();
+        if (note != NOTE_NONE && note != last) {
+            char name[5];
+            chart_note_name(note, name);
+            fprintf(output, "%.2f\t%s\n", (double)offset / (audio->channels * audio->sample_rate), name);
+            last = note;
+        }
+        double t6 = now_seconds();
+        st->downmix += t2 - t1;
+        st->fft += t3 - t2;
+        st->peak += t4 - t3;
+        st->classify += t5 - t4;
+        st->write += t6 - t5;
+        st->frames++;
+    }
+    t0 = now_seconds();
+    fclose(output);
+    st->write += now_seconds() - t0;
+    kiss_fftr_free(fft);
+}
+
+// Compara o mapa gerado com o gabarito: uma nota detectada acerta se a mesma nota do
+// gabarito comeca a no maximo um frame de distancia e ainda nao foi usada
+static void score_chart(const char* filename, const TruthNote* truth, int truth_count, double tolerance,
+                        int* detected, int* hits) {
+    static char used[MAX_BENCH_NOTES];
+    memset(used, 0, sizeof(used));
+    *detected = 0;
+    *hits = 0;
+    FILE* f = fopen(filename, "r");
+    if (!f) return;
+    float time;
+    char name[5];
+    while (fscanf(f, "%f %4s", &time, name) == 2) {
+        int note = chart_note_from_name(name);
+        (*detected)++;
+        for (int i = 0; i < truth_count; i++) {
+            if (!used[i] && truth[i].note == note && fabs(truth[i].time - time) <= tolerance) {
+                used[i] = 1;
+                (*hits)++;
+                break;
+            }
+        }
+    }
+    fclose(f);
+}
+
+int main(void) {
+    static const char* const window_names[] = { "rect", "hann", "blackman" };
+    static TruthNote truth[MAX_BENCH_NOTES];
+
+    printf("sample_rate,channels,seconds,window,hop,frames,"
+           "downmix_fps,fft_fps,peak_fps,classify_fps,write_fps,"
+           "pipeline_s,pipeline_x_realtime,truth_notes,detected_notes,precision,recall\n");
+
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        const BenchConfig* cfg = &configs[c];
+        int truth_count;
+        AudioData* audio = make_audio(cfg, truth, &truth_count);
+
+        StageTimes st;
+        time_stages(audio, cfg, &st);
+
+        // O pipeline de verdade, como o criador_mapa roda em uma thread
+        AnalysisOptions options = ANALYSIS_OPTIONS_DEFAULT;
+        options.window = cfg->window;
+        options.hop_size = cfg->hop_size;
+        AnalysisPlan* plan = analysis_plan_alloc(&options);
+        double t0 = now_seconds();
+        analyze_audio_with_plan(audio, BENCH_OUTPUT, plan);
+        double pipeline = now_seconds() - t0;
+        analysis_plan_free(plan);
+
+        int detected, hits;
+        score_chart(BENCH_OUTPUT, truth, truth_count, (double)FRAME_SIZE / cfg->sample_rate, &detected, &hits);
+
+        printf("%d,%d,%d,%s,%d,%ld,%.0f,%.0f,%.0f,%.0f,%.0f,%.4f,%.1f,%d,%d,%.4f,%.4f\n",
+               cfg->sample_rate, cfg->channels, cfg->seconds, window_names[cfg->window], cfg->hop_size, st.frames,
+               st.frames / st.downmix, st.frames / st.fft, st.frames / st.peak,
+               st.frames / st.classify, st.frames / st.write,
+               pipeline, cfg->seconds / pipeline, truth_count, detected,
+               detected ? (double)hits / detected : 0.0, (double)hits / truth_count);
+        free_audio_data(audio);
+    }
+
+    remove(BENCH_OUTPUT);
+    return 0;
+}
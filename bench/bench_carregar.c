@@ -0,0 +1,105 @@
+//=======================================================
+// Arquivo: bench_carregar.c
+// Descrição: Tempo de carregar um notes.txt sintetico de
+// 1 milhao de linhas ("%.2f\t%s", como o analisador
+// grava): o carregador antigo, duas passadas de fscanf,
+// contra level_notes_load_text, que mapeia o arquivo e
+// le os numeros sem stdio. Confere se os dois dao as
+// mesmas notas, e mostra os erros de uma linha estragada.
+//=======================================================
+
+#include "notas_nivel.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_LINES 1000000
+#define BENCH_FILE "bench_carregar.txt"
+#define BENCH_BAD_FILE "bench_carregar_ruim.txt"
+
+static int lane_for_name(const char* name) {
+    switch (name[0]) {
+        case 'C': case 'D': return 0;
+        case 'E': case 'F': return 1;
+        case 'G': case 'A': return 2;
+        case 'B': return 3;
+    }
+    return -1;
+}
+
+// O carregador antigo: conta as notas com fscanf, aloca e le de novo (o mapa ja vem em ordem)
+static int load_fscanf(LevelNotes* notes, const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (!file) return -1;
+    float timestamp;
+    char name[16];
+    int count = 0;
+    while (fscanf(file, "%f %15s", &timestamp, name) == 2) count += lane_for_name(name) >= 0;
+
+    level_notes_free(notes);
+    if (level_notes_alloc(notes, count) != 0) {
+        fclose(file);
+        return -1;
+    }
+    rewind(file);
+    int n = 0;
+    while (n < count && fscanf(file, "%f %15s", &timestamp, name) == 2) {
+        int lane = lane_for_name(name);
+        if (lane < 0) continue;
+        notes->timestamps[n] = timestamp;
+        notes->lanes[n] = (uint8_t)lane;
+        n++;
+    }
+    fclose(file);
+    return n;
+}
+
+int main(void) {
+    static const char* names[] = { "C2", "C#3", "D4", "E3", "F#4", "G2", "A#5", "B3" };
+
+    FILE* f = fopen(BENCH_FILE, "w");
+    if (!f) {
+        printf("Erro: nao foi possivel criar %s\n", BENCH_FILE);
+        return 1;
+    }
+    unsigned int seed = 3;
+    double t = 0;
+    for (int i = 0; i < BENCH_LINES; i++) {
+        seed = seed * 1103515245 + 12345;
+        t += ((seed >> 16) % 50) / 100.0;
+        fprintf(f, "%.2f\t%s\n", t, names[(seed >> 8) % 8]);
+    }
+    fclose(f);
+
+    LevelNotes old_notes = {0}, new_notes = {0};
+    double t0 = now_seconds();
+    int old_count = load_fscanf(&old_notes, BENCH_FILE);
+    double t_old = now_seconds() - t0;
+
+    t0 = now_seconds();
+    int new_count = level_notes_load_text(&new_notes, BENCH_FILE);
+    double t_new = now_seconds() - t0;
+
+    int same = old_count == new_count && old_count > 0 &&
+               memcmp(old_notes.timestamps, new_notes.timestamps, old_count * sizeof(float)) == 0 &&
+               memcmp(old_notes.lanes, new_notes.lanes, old_count) == 0;
+    printf("linhas,metodo,ms,notas,iguais\n");
+    printf("%d,fscanf,%.1f,%d,%s\n", BENCH_LINES, t_old * 1e3, old_count, same ? "sim" : "NAO");
+    printf("%d,mmap,%.1f,%d,%s\n", BENCH_LINES, t_new * 1e3, new_count, same ? "sim" : "NAO");
+    printf("ganho: %.1fx\n", t_old / t_new);
+
+    // Linhas estragadas: cada uma sai com o numero, e o resto do mapa carrega
+    f = fopen(BENCH_BAD_FILE, "w");
+    if (f) {
+        fprintf(f, "0.50\tC4\n1,25\tE4\n\n2.00\n3.00\tG4 extra\n4.5e0\tB4\r\nx\tA4\n");
+        fclose(f);
+        printf("%s: %d notas\n", BENCH_BAD_FILE, level_notes_load_text(&new_notes, BENCH_BAD_FILE));
+        remove(BENCH_BAD_FILE);
+    }
+
+    remove(BENCH_FILE);
+    level_notes_free(&old_notes);
+    level_notes_free(&new_notes);
+    return 0;
+}
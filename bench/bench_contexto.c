@@ -0,0 +1,90 @@
+//=======================================================
+// Arquivo: bench_contexto.c
+// Descrição: Mapeia as musicas dadas na linha de comando
+// varias vezes com um mesmo AnalysisPlan e conta as
+// alocacoes no heap de cada musica, comparando com o
+// caminho sem plano (load_mp3_file + analise). Depois
+// das primeiras musicas, o plano nao deve alocar nada.
+// O contador intercepta malloc/calloc/realloc no link:
+//   gcc ... -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+//   ./bench_contexto musicas/*.mp3 > contexto.csv
+//=======================================================
+
+#include "mapeamento_audio.h"
+#include "bench_util.h"
+
+#define BENCH_OUTPUT "bench_contexto.txt"
+#define PASSES 3
+
+static long heap_allocations = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    heap_allocations++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    heap_allocations++;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    heap_allocations++;
+    return __real_realloc(ptr, size);
+}
+
+// Alocacoes do caminho de cada musica sem contexto: buffer do MP3, AudioData e PCM (as que a
+// libc faz por dentro, como a do fopen, nao passam pelo --wrap)
+static long allocations_without_plan(const char* mp3, AnalysisPlan* plan) {
+    long before = heap_allocations;
+    AudioData* audio_data = load_mp3_file(mp3);
+    if (!audio_data) return -1;
+    analyze_audio_with_plan(audio_data, BENCH_OUTPUT, plan);
+    free_audio_data(audio_data);
+    return heap_allocations - before;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Uso: %s <musica.mp3>...\n", argv[0]);
+        return -1;
+    }
+
+    AnalysisOptions options = ANALYSIS_OPTIONS_DEFAULT;
+    AnalysisPlan* plan = analysis_plan_alloc(&options);
+    AnalysisPlan* reference = analysis_plan_alloc(&options);
+    if (!plan || !reference) return -1;
+
+    printf("passe,arquivo,audio_s,tempo_s,alocacoes,alocacoes_sem_plano,memoria_plano_mb\n");
+    long steady = 0;
+    for (int pass = 1; pass <= PASSES; pass++) {
+        for (int i = 1; i < argc; i++) {
+            long before = heap_allocations;
+            double t0 = now_seconds();
+            int result = analyze_mp3_with_plan(plan, argv[i], BENCH_OUTPUT);
+            double elapsed = now_seconds() - t0;
+            long allocations = heap_allocations - before;
+            if (result != 0) continue;
+            if (pass > 1) steady += allocations;
+
+            AnalysisPlanStats stats;
+            analysis_plan_stats(plan, &stats);
+            printf("%d,%s,%.1f,%.4f,%ld,%ld,%.1f\n", pass, argv[i], stats.audio_seconds, elapsed, allocations,
+                   allocations_without_plan(argv[i], reference), stats.reserved_bytes / (1024.0 * 1024.0));
+            fflush(stdout);
+        }
+    }
+
+    AnalysisPlanStats stats;
+    analysis_plan_stats(plan, &stats);
+    fprintf(stderr, "%ld musicas, %ld alocacoes do plano no total, %ld depois do primeiro passe\n",
+            stats.songs, stats.allocations, steady);
+    analysis_plan_free(plan);
+    analysis_plan_free(reference);
+    remove(BENCH_OUTPUT);
+    return steady == 0 ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+//=======================================================
+// Arquivo: bench_decimacao.c
+// Descrição: Compara a analise em taxa cheia com a analise
+// da copia decimada (decimacao.c) em audio sintetico de
+// gabarito conhecido: tempo (na decimada, filtro +
+// analise), PCM residente e precisao/revocacao das
+// notas. Saida em CSV, como o bench_analise.
+//=======================================================
+
+#include "mapeamento_audio.h"
+#include "mapa_compilado.h"
+#include "bench_util.h"
+#include <string.h>
+
+#define BENCH_OUTPUT "bench_decimacao.txt"
+#define NOTE_SECONDS 0.5
+#define MAX_BENCH_NOTES 4096
+
+typedef struct {
+    int sample_rate;
+    int channels;
+    int seconds;
+} BenchConfig;
+
+static const BenchConfig configs[] = {
+    { 22050, 1, 60 },
+    { 44100, 2, 60 },
+    { 48000, 2, 60 },
+    { 44100, 2, 240 },
+};
+
+// A musica de gabarito do bench_util.h, com notas de NOTE_SECONDS
+static AudioData* make_audio(const BenchConfig* cfg, TruthNote* truth, int* truth_count) {
+    AudioData* audio = (AudioData*)malloc(sizeof(AudioData));
+    size_t frames = (size_t)cfg->seconds * cfg->sample_rate;
+    audio->pcm_buffer = (short*)malloc(frames * cfg->channels * sizeof(short));
+    audio->pcm_size = frames * cfg->channels;
+    audio->sample_rate = cfg->sample_rate;
+    audio->channels = cfg->channels;
+    bench_truth_song(audio->pcm_buffer, frames, cfg->channels, cfg->sample_rate, NOTE_SECONDS, NUM_NOTES,
+                     truth, truth_count);
+    return audio;
+}
+
+static void score_chart(const TruthNote* truth, int truth_count, double tolerance, int* detected, int* hits) {
+    static char used[MAX_BENCH_NOTES];
+    memset(used, 0, sizeof(used));
+    *detected = 0;
+    *hits = 0;
+    FILE* f = fopen(BENCH_OUTPUT, "r");
+    if (!f) return;
+    float time;
+    char name[5];
+    while (fscanf(f, "%f %4s", &time, name) == 2) {
+        int note = chart_note_from_name(name);
+        (*detected)++;
+        for (int i = 0; i < truth_count; i++) {
+            if (!used[i] && truth[i].note == note && fabs(truth[i].time - time) <= tolerance) {
+                used[i] = 1;
+                (*hits)++;
+                break;
+            }
+        }
+    }
+    fclose(f);
+}
+
+static void report(const char* path, const BenchConfig* cfg, double seconds, size_t pcm_bytes,
+                   const TruthNote* truth, int truth_count) {
+    int detected, hits;
+    score_chart(truth, truth_count, (double)FRAME_SIZE / cfg->sample_rate, &detected, &hits);
+    printf("%d,%d,%d,%s,%.4f,%.1f,%zu,%d,%d,%.4f,%.4f\n", cfg->sample_rate, cfg->channels, cfg->seconds, path,
+           seconds, cfg->seconds / seconds, pcm_bytes, truth_count, detected,
+           detected ? (double)hits / detected : 0.0, (double)hits / truth_count);
+}
+
+int main(void) {
+    static TruthNote truth[MAX_BENCH_NOTES];
+    AnalysisOptions options = ANALYSIS_OPTIONS_DEFAULT;
+
+    printf("sample_rate,channels,seconds,path,analysis_s,x_realtime,pcm_bytes,truth_notes,detected_notes,precision,recall\n");
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        const BenchConfig* cfg = &configs[c];
+        int truth_count;
+        AudioData* audio = make_audio(cfg, truth, &truth_count);
+
+        AnalysisPlan* plan = analysis_plan_alloc(&options);
+        double t0 = now_seconds();
+        analyze_audio_with_plan(audio, BENCH_OUTPUT, plan);
+        double full = now_seconds() - t0;
+        analysis_plan_free(plan);
+        report("full", cfg, full, audio->pcm_size * sizeof(short), truth, truth_count);
+
+        // Decimacao + analise, como o --decimar do criador_mapa
+        t0 = now_seconds();
+        int factor = decimation_factor_for_rate(audio->sample_rate);
+        DecimatedAudio* low_band = decimate_pcm(audio->pcm_buffer, audio->pcm_size, audio->channels,
+                                                audio->sample_rate, factor);
+        analyze_decimated_to_file(low_band, BENCH_OUTPUT, &options);
+        double total = now_seconds() - t0;
+        report("decimated", cfg, total, low_band->size * sizeof(float), truth, truth_count);
+
+        free_decimated_audio(low_band);
+        free_audio_data(audio);
+    }
+
+    remove(BENCH_OUTPUT);
+    return 0;
+}
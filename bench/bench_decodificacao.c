@@ -0,0 +1,69 @@
+//=======================================================
+// Arquivo: bench_decodificacao.c
+// Descrição: Compara a decodificacao sequencial do MP3
+// (load_mp3_file) com a paralela (decodificacao_paralela.c)
+// de 1 a 16 threads: tempo, speedup e se o PCM saiu
+// identico amostra por amostra. Saida em CSV:
+//   ./bench_decodificacao musicas/*.mp3 > decodificacao.csv
+//=======================================================
+
+#include "decodificacao_paralela.h"
+#include "bench_util.h"
+#include <string.h>
+
+#define REPEATS 3             // vale o melhor tempo
+
+static const int thread_counts[] = { 1, 2, 4, 8, 16 };
+
+static int same_audio(const AudioData* a, const AudioData* b) {
+    return a->pcm_size == b->pcm_size && a->sample_rate == b->sample_rate && a->channels == b->channels &&
+           memcmp(a->pcm_buffer, b->pcm_buffer, a->pcm_size * sizeof(short)) == 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Uso: %s <musica.mp3>...\n", argv[0]);
+        return 1;
+    }
+
+    int all_identical = 1;
+    printf("file,audio_s,threads,decode_s,x_realtime,speedup,identical\n");
+    for (int i = 1; i < argc; i++) {
+        AudioData* reference = NULL;
+        double sequential = 1e9;
+        for (int r = 0; r < REPEATS; r++) {
+            double t0 = now_seconds();
+            AudioData* audio = load_mp3_file(argv[i]);
+            double t = now_seconds() - t0;
+            if (!audio) break;
+            if (t < sequential) sequential = t;
+            if (reference) free_audio_data(reference);
+            reference = audio;
+        }
+        if (!reference || reference->sample_rate == 0) {
+            fprintf(stderr, "Ignorando '%s'.\n", argv[i]);
+            free_audio_data(reference);
+            continue;
+        }
+        double audio_seconds = (double)reference->pcm_size / (reference->channels * reference->sample_rate);
+        printf("%s,%.1f,sequential,%.4f,%.1f,1.00,1\n", argv[i], audio_seconds, sequential, audio_seconds / sequential);
+
+        for (size_t c = 0; c < sizeof(thread_counts) / sizeof(thread_counts[0]); c++) {
+            double best = 1e9;
+            int identical = 1;
+            for (int r = 0; r < REPEATS; r++) {
+                double t0 = now_seconds();
+                AudioData* audio = load_mp3_file_parallel(argv[i], thread_counts[c]);
+                double t = now_seconds() - t0;
+                if (t < best) best = t;
+                identical = identical && audio && same_audio(reference, audio);
+                free_audio_data(audio);
+            }
+            all_identical = all_identical && identical;
+            printf("%s,%.1f,%d,%.4f,%.1f,%.2f,%d\n", argv[i], audio_seconds, thread_counts[c], best,
+                   audio_seconds / best, sequential / best, identical);
+        }
+        free_audio_data(reference);
+    }
+    return all_identical ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+//=======================================================
+// Arquivo: bench_erros.c
+// Descrição: Custo de update_game achar as notas que
+// sairam da janela de acerto em mapas densos de 1 milhao
+// de notas (100 a 10 mil notas por segundo), tocados
+// frame a frame a 60 fps: o laço original, nota a nota
+// em double, contra os kernels de notas_nivel.c que
+// comparam 8 tempos por vez e contam os erros com
+// popcount. Um terço das notas ja foi acertado. Confere
+// se todos marcam as mesmas notas e contam os mesmos erros.
+//=======================================================
+
+#include "notas_nivel.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_NOTES 1000000
+#define BENCH_FPS 60.0
+#define BENCH_WINDOW 0.2
+
+// O laço original de update_game
+static int expire_linear(LevelNotes* notes, int first, int count, double t, double window, int* misses) {
+    *misses = 0;
+    while (first < count && t > notes->timestamps[first] + window) {
+        int i = first++;
+        if (!level_note_bit(notes->processed, i)) {
+            level_note_set(notes->processed, i);
+            if (!level_note_bit(notes->pressed, i)) (*misses)++;
+        }
+    }
+    return first;
+}
+
+// Toca o mapa do começo ao fim; devolve o total de erros e o tempo gasto em *seconds
+static long play(LevelNotesExpireFn expire, LevelNotes* notes, double* seconds) {
+    double end = notes->timestamps[BENCH_NOTES - 1] + 2 * BENCH_WINDOW;
+    long total = 0;
+    int frontier = 0;
+    double t0 = now_seconds();
+    for (long frame = 0; frame / BENCH_FPS < end; frame++) {
+        int misses;
+        frontier = expire(notes, frontier, BENCH_NOTES, frame / BENCH_FPS, BENCH_WINDOW, &misses);
+        total += misses;
+    }
+    *seconds = now_seconds() - t0;
+    return total;
+}
+
+int main(void) {
+    static const double densities[] = { 100, 1000, 10000 };
+    static const struct { const char* name; LevelNotesExpireFn fn; } methods[] = {
+        { "laco", expire_linear },
+        { "scalar", level_notes_expire_scalar },
+#if defined(__x86_64__) || defined(__i386__)
+        { "sse2", level_notes_expire_sse2 },
+        { "avx", level_notes_expire_avx },
+#endif
+    };
+    const int method_count = sizeof(methods) / sizeof(methods[0]);
+    size_t words = (BENCH_NOTES + 63) / 64;
+
+    LevelNotes notes, reference;
+    if (level_notes_alloc(&notes, BENCH_NOTES) != 0 || level_notes_alloc(&reference, BENCH_NOTES) != 0) {
+        fprintf(stderr, "Erro: sem memoria para %d notas\n", BENCH_NOTES);
+        return 1;
+    }
+
+    printf("kernel do jogo: %s\n", level_notes_expire_kernel_name());
+    printf("notas_por_s,metodo,ns_por_nota,erros,iguais\n");
+    for (size_t d = 0; d < sizeof(densities) / sizeof(densities[0]); d++) {
+        // Tempos com jitter, varios caindo no mesmo frame e na borda da janela
+        unsigned int seed = 7;
+        for (int i = 0; i < BENCH_NOTES; i++) {
+            seed = seed * 1103515245 + 12345;
+            notes.timestamps[i] = (float)((i + ((seed >> 16) & 0xFF) / 256.0) / densities[d]);
+        }
+        for (int i = 1; i < BENCH_NOTES; i++)
+            if (notes.timestamps[i] < notes.timestamps[i - 1]) notes.timestamps[i] = notes.timestamps[i - 1];
+
+        long reference_misses = 0;
+        for (int m = 0; m < method_count; m++) {
+            if (m > 0 && strcmp(methods[m].name, "avx") == 0 && !__builtin_cpu_supports("avx")) continue;
+            memset(notes.processed, 0, words * sizeof(uint64_t));
+            memset(notes.pressed, 0, words * sizeof(uint64_t));
+            for (int i = 0; i < BENCH_NOTES; i += 3) {
+                level_note_set(notes.processed, i);
+                level_note_set(notes.pressed, i);
+            }
+
+            double seconds;
+            long misses = play(methods[m].fn, &notes, &seconds);
+            if (m == 0) {
+                reference_misses = misses;
+                memcpy(reference.processed, notes.processed, words * sizeof(uint64_t));
+            }
+            int same = misses == reference_misses &&
+                       memcmp(reference.processed, notes.processed, words * sizeof(uint64_t)) == 0;
+            printf("%.0f,%s,%.2f,%ld,%s\n", densities[d], methods[m].name, seconds * 1e9 / BENCH_NOTES,
+                   misses, same ? "sim" : "NAO");
+        }
+    }
+
+    level_notes_free(&notes);
+    level_notes_free(&reference);
+    return 0;
+}
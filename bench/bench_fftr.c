@@ -0,0 +1,77 @@
+//=======================================================
+// Arquivo: bench_fftr.c
+// Descrição: Compara a FFT complexa (kiss_fft com .i = 0)
+// com a FFT real (kiss_fftr) no mesmo PCM, no tamanho de
+// frame usado pelo analisador de notas.
+//=======================================================
+
+#include "kiss_fft.h"
+#include "kiss_fftr.h"
+#include "mapeamento_audio.h"
+#include "bench_util.h"
+
+#define BENCH_FRAMES 2000
+#define BENCH_SAMPLE_RATE 44100
+
+// Mono PCM with one tone per frame, cycling through a few notes, plus some noise
+int main(void) {
+    short* pcm = (short*)malloc((size_t)BENCH_FRAMES * FRAME_SIZE * sizeof(short));
+    bench_tones(pcm, (size_t)BENCH_FRAMES * FRAME_SIZE, 1, BENCH_SAMPLE_RATE, FRAME_SIZE);
+    int* peaks_complex = (int*)malloc(BENCH_FRAMES * sizeof(int));
+    int* peaks_real = (int*)malloc(BENCH_FRAMES * sizeof(int));
+
+    kiss_fft_cfg cfg = kiss_fft_alloc(FRAME_SIZE, 0, NULL, NULL);
+    kiss_fft_cpx cin[FRAME_SIZE], cout[FRAME_SIZE];
+    double t0 = now_seconds();
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        const short* frame = pcm + (size_t)f * FRAME_SIZE;
+        for (int i = 0; i < FRAME_SIZE; i++) {
+            cin[i].r = (float)frame[i] / 32768.0f;
+            cin[i].i = 0;
+        }
+        kiss_fft(cfg, cin, cout);
+        float max_mag = 0;
+        peaks_complex[f] = 0;
+        for (int i = 1; i < FRAME_SIZE / 2; i++) {
+            float mag = sqrt(cout[i].r * cout[i].r + cout[i].i * cout[i].i);
+            if (mag > max_mag) { max_mag = mag; peaks_complex[f] = i; }
+        }
+    }
+    double t_complex = now_seconds() - t0;
+    kiss_fft_free(cfg);
+
+    kiss_fftr_cfg rcfg = kiss_fftr_alloc(FRAME_SIZE, 0, NULL, NULL);
+    kiss_fft_scalar rin[FRAME_SIZE];
+    kiss_fft_cpx rout[FRAME_SIZE / 2 + 1];
+    t0 = now_seconds();
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        const short* frame = pcm + (size_t)f * FRAME_SIZE;
+        for (int i = 0; i < FRAME_SIZE; i++) {
+            rin[i] = (float)frame[i] / 32768.0f;
+        }
+        kiss_fftr(rcfg, rin, rout);
+        float max_mag = 0;
+        peaks_real[f] = 0;
+        for (int i = 1; i < FRAME_SIZE / 2; i++) {
+            float mag = sqrt(rout[i].r * rout[i].r + rout[i].i * rout[i].i);
+            if (mag > max_mag) { max_mag = mag; peaks_real[f] = i; }
+        }
+    }
+    double t_real = now_seconds() - t0;
+    kiss_fftr_free(rcfg);
+
+    int iguais = 0;
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        iguais += peaks_complex[f] == peaks_real[f];
+    }
+
+    printf("Frames: %d x %d amostras\n", BENCH_FRAMES, FRAME_SIZE);
+    printf("kiss_fft  (complexa): %8.2f ms total, %6.2f us/frame\n", t_complex * 1e3, t_complex * 1e6 / BENCH_FRAMES);
+    printf("kiss_fftr (real)    : %8.2f ms total, %6.2f us/frame\n", t_real * 1e3, t_real * 1e6 / BENCH_FRAMES);
+    printf("Speedup: %.2fx | picos iguais: %d/%d\n", t_complex / t_real, iguais, BENCH_FRAMES);
+
+    free(pcm);
+    free(peaks_complex);
+    free(peaks_real);
+    return 0;
+}
@@ -0,0 +1,146 @@
+//=======================================================
+// Arquivo: bench_goertzel.c
+// Descrição: Compara os motores que so calculam os bins
+// das notas (banco de Goertzel e DFT deslizante, em
+// banco_notas.c) com a FFT inteira, para varios hops:
+// tempo da analise (PCM ja decodificado), janelas por
+// segundo e concordancia das notas com o mapa da FFT do
+// mesmo hop. Saida em CSV, uma linha por musica, hop e
+// motor:
+//   ./bench_goertzel musicas/*.mp3 > goertzel.csv
+//=======================================================
+
+#include "mapeamento_audio.h"
+#include "mapa_compilado.h"
+#include "bench_util.h"
+
+#define BENCH_FFT_OUTPUT "bench_goertzel_fft.txt"
+#define BENCH_OUTPUT "bench_goertzel.txt"
+#define REPEATS 3             // vale o melhor tempo
+
+typedef struct {
+    float time;
+    int note;
+} ChartNote;
+
+static const int HOPS[] = { 4096, 2048, 1024, 512, 256, 128, 64 };
+static const AnalysisEngine ENGINES[] = { ANALYSIS_ENGINE_FFT, ANALYSIS_ENGINE_GOERTZEL, ANALYSIS_ENGINE_SDFT };
+static const char* ENGINE_NAMES[] = { "fft", "mdct", "goertzel", "sdft" };
+
+static ChartNote* read_chart(const char* filename, int* count) {
+    int capacity = 1024;
+    ChartNote* notes = (ChartNote*)malloc(capacity * sizeof(ChartNote));
+    *count = 0;
+    FILE* f = fopen(filename, "r");
+    if (!f || !notes) {
+        if (f) fclose(f);
+        return notes;
+    }
+    float time;
+    char name[5];
+    while (notes && fscanf(f, "%f %4s", &time, name) == 2) {
+        if (*count == capacity) {
+            capacity *= 2;
+            ChartNote* grown = (ChartNote*)realloc(notes, capacity * sizeof(ChartNote));
+            if (!grown) break;
+            notes = grown;
+        }
+        notes[*count].time = time;
+        notes[*count].note = chart_note_from_name(name);
+        (*count)++;
+    }
+    fclose(f);
+    return notes;
+}
+
+// Notas com uma nota igual da FFT a no maximo um hop de distancia, ainda nao usada
+static int count_agreement(const ChartNote* ref, int ref_count, const ChartNote* notes, int count,
+                           double tolerance) {
+    char* used = (char*)calloc(ref_count > 0 ? ref_count : 1, 1);
+    int hits = 0;
+    int first = 0;
+    for (int i = 0; i < count && used; i++) {
+        while (first < ref_count && ref[first].time < notes[i].time - tolerance) first++;
+        for (int j = first; j < ref_count && ref[j].time <= notes[i].time + tolerance; j++) {
+            if (!used[j] && ref[j].note == notes[i].note) {
+                used[j] = 1;
+                hits++;
+                break;
+            }
+        }
+    }
+    free(used);
+    return hits;
+}
+
+static double time_engine(AudioData* audio, const char* output, const AnalysisOptions* options) {
+    AnalysisPlan* plan = analysis_plan_alloc(options);
+    if (!plan) return -1;
+    double best = 1e9;
+    for (int r = 0; r < REPEATS; r++) {
+        double t0 = now_seconds();
+        analyze_audio_with_plan(audio, output, plan);
+        double t = now_seconds() - t0;
+        if (t < best) best = t;
+    }
+    analysis_plan_free(plan);
+    return best;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Uso: %s <musica.mp3>...\n", argv[0]);
+        return 1;
+    }
+
+    printf("file,hop,engine,analysis_s,windows_per_s,speedup_vs_fft,agreement_precision,agreement_recall\n");
+    for (int i = 1; i < argc; i++) {
+        AudioData* audio = load_mp3_file(argv[i]);
+        if (!audio || audio->channels == 0) {
+            fprintf(stderr, "Ignorando '%s'.\n", argv[i]);
+            free_audio_data(audio);
+            continue;
+        }
+
+        for (size_t h = 0; h < sizeof(HOPS) / sizeof(HOPS[0]); h++) {
+            AnalysisOptions options = ANALYSIS_OPTIONS_DEFAULT;
+            options.hop_size = HOPS[h];
+            long window_size = (long)FRAME_SIZE * audio->channels;
+            long windows = (long)audio->pcm_size > window_size
+                         ? ((long)audio->pcm_size - window_size - 1) / ((long)HOPS[h] * audio->channels) + 1 : 0;
+            double fft = 0;
+            int ref_count = 0;
+            ChartNote* ref = NULL;
+
+            for (size_t e = 0; e < sizeof(ENGINES) / sizeof(ENGINES[0]); e++) {
+                options.engine = ENGINES[e];
+                const char* output = ENGINES[e] == ANALYSIS_ENGINE_FFT ? BENCH_FFT_OUTPUT : BENCH_OUTPUT;
+                double t = time_engine(audio, output, &options);
+                if (t < 0) continue;
+                if (ENGINES[e] == ANALYSIS_ENGINE_FFT) {
+                    fft = t;
+                    ref = read_chart(BENCH_FFT_OUTPUT, &ref_count);
+                }
+
+                int count = ref_count;
+                int hits = ref_count;
+                if (ENGINES[e] != ANALYSIS_ENGINE_FFT) {
+                    ChartNote* notes = read_chart(BENCH_OUTPUT, &count);
+                    hits = ref && notes ? count_agreement(ref, ref_count, notes, count,
+                                                          (double)HOPS[h] / audio->sample_rate) : 0;
+                    free(notes);
+                }
+                printf("%s,%d,%s,%.4f,%.0f,%.2f,%.4f,%.4f\n", argv[i], HOPS[h], ENGINE_NAMES[ENGINES[e]], t,
+                       t > 0 ? windows / t : 0.0, t > 0 ? fft / t : 0.0,
+                       count ? (double)hits / count : 1.0, ref_count ? (double)hits / ref_count : 1.0);
+                fflush(stdout);
+            }
+            free(ref);
+        }
+        free_audio_data(audio);
+    }
+
+    remove(BENCH_FFT_OUTPUT);
+    remove(BENCH_OUTPUT);
+    return 0;
+}
@@ -0,0 +1,85 @@
+//=======================================================
+// Arquivo: bench_lotes.c
+// Descrição: Compara a FFT real frame a frame (kiss_fftr
+// + spectrum_peak, como detect_frame_note) com a FFT em
+// lotes de 4 frames do fft_lotes.c (kiss_fft com
+// USE_SIMD), no mesmo PCM e com a mesma janela. Confere
+// se o pico e a magnitude de cada frame sao identicos.
+//=======================================================
+
+#include "kiss_fftr.h"
+#include "pico_espectral.h"
+#include "fft_lotes.h"
+#include "mapeamento_audio.h"
+#include "bench_util.h"
+
+#define BENCH_FRAMES 2000
+#define BENCH_RUNS 5              // vale o melhor tempo
+#define BENCH_SAMPLE_RATE 44100
+
+// Mono PCM with one tone per frame, cycling through a few notes, plus some noise
+int main(void) {
+    short* pcm = (short*)malloc((size_t)BENCH_FRAMES * FRAME_SIZE * sizeof(short));
+    bench_tones(pcm, (size_t)BENCH_FRAMES * FRAME_SIZE, 1, BENCH_SAMPLE_RATE, FRAME_SIZE);
+    int* peaks_frame = (int*)malloc(BENCH_FRAMES * sizeof(int));
+    int* peaks_batch = (int*)malloc(BENCH_FRAMES * sizeof(int));
+    float* sq_frame = (float*)malloc(BENCH_FRAMES * sizeof(float));
+    float* sq_batch = (float*)malloc(BENCH_FRAMES * sizeof(float));
+    float window[FRAME_SIZE];
+    window_build(window, FRAME_SIZE, WINDOW_HANN, 1);
+
+    kiss_fftr_cfg cfg = kiss_fftr_alloc(FRAME_SIZE, 0, NULL, NULL);
+    kiss_fft_scalar in[FRAME_SIZE];
+    kiss_fft_cpx out[FRAME_SIZE / 2 + 1];
+    double t_frame = 1e9;
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        double t0 = now_seconds();
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            window_apply(pcm + (size_t)f * FRAME_SIZE, 1, window, in, FRAME_SIZE);
+            kiss_fftr(cfg, in, out);
+            peaks_frame[f] = spectrum_peak(out, 1, FRAME_SIZE / 2, &sq_frame[f]);
+        }
+        double t = now_seconds() - t0;
+        if (t < t_frame) t_frame = t;
+    }
+    kiss_fftr_free(cfg);
+
+    FftBatch* batch = fft_batch_alloc(FRAME_SIZE);
+    if (!batch) {
+        printf("FFT em lotes indisponivel nesta CPU (sem SSE2).\n");
+        return 1;
+    }
+    double t_batch = 1e9;
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        double t0 = now_seconds();
+        for (int f = 0; f < BENCH_FRAMES; f += FFT_BATCH_LANES) {
+            int count = BENCH_FRAMES - f < FFT_BATCH_LANES ? BENCH_FRAMES - f : FFT_BATCH_LANES;
+            for (int l = 0; l < count; l++) {
+                window_apply(pcm + (size_t)(f + l) * FRAME_SIZE, 1, window, fft_batch_lane(batch, l), FRAME_SIZE);
+            }
+            fft_batch_peaks(batch, count, 1, FRAME_SIZE / 2, peaks_batch + f, sq_batch + f);
+        }
+        double t = now_seconds() - t0;
+        if (t < t_batch) t_batch = t;
+    }
+    fft_batch_free(batch);
+
+    int iguais = 0;
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        iguais += peaks_frame[f] == peaks_batch[f] && sq_frame[f] == sq_batch[f];
+    }
+
+    printf("Frames: %d x %d amostras, janela hann, pico com kernel %s\n", BENCH_FRAMES, FRAME_SIZE,
+           spectrum_peak_kernel_name());
+    printf("kiss_fftr frame a frame: %8.2f ms total, %6.2f us/frame\n", t_frame * 1e3, t_frame * 1e6 / BENCH_FRAMES);
+    printf("lotes de %d (USE_SIMD) : %8.2f ms total, %6.2f us/frame\n", FFT_BATCH_LANES, t_batch * 1e3,
+           t_batch * 1e6 / BENCH_FRAMES);
+    printf("Speedup: %.2fx | picos e magnitudes iguais: %d/%d\n", t_frame / t_batch, iguais, BENCH_FRAMES);
+
+    free(pcm);
+    free(peaks_frame);
+    free(peaks_batch);
+    free(sq_frame);
+    free(sq_batch);
+    return 0;
+}
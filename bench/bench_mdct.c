@@ -0,0 +1,149 @@
+//=======================================================
+// Arquivo: bench_mdct.c
+// Descrição: Compara o analisador FFT (decodifica o PCM
+// e roda a kiss_fft) com o experimental das linhas MDCT
+// (analise_mdct.c) num corpus de MP3 dado na linha de
+// comando: tempo de cada um, do arquivo ate o mapa, e a
+// concordancia das notas tomando o mapa da FFT como
+// referencia. Saida em CSV, uma linha por musica:
+//   ./bench_mdct musicas/*.mp3 > mdct.csv
+//=======================================================
+
+#include "mapeamento_audio.h"
+#include "mapa_compilado.h"
+#include "bench_util.h"
+#include <string.h>
+
+#define BENCH_FFT_OUTPUT "bench_mdct_fft.txt"
+#define BENCH_MDCT_OUTPUT "bench_mdct.txt"
+#define REPEATS 3             // vale o melhor tempo de cada analisador
+
+typedef struct {
+    float time;
+    int note;
+} ChartNote;
+
+static ChartNote* read_chart(const char* filename, int* count) {
+    int capacity = 1024;
+    ChartNote* notes = (ChartNote*)malloc(capacity * sizeof(ChartNote));
+    *count = 0;
+    FILE* f = fopen(filename, "r");
+    if (!f || !notes) {
+        if (f) fclose(f);
+        return notes;
+    }
+    float time;
+    char name[5];
+    while (notes && fscanf(f, "%f %4s", &time, name) == 2) {
+        if (*count == capacity) {
+            capacity *= 2;
+            ChartNote* grown = (ChartNote*)realloc(notes, capacity * sizeof(ChartNote));
+            if (!grown) break;
+            notes = grown;
+        }
+        notes[*count].time = time;
+        notes[*count].note = chart_note_from_name(name);
+        (*count)++;
+    }
+    fclose(f);
+    return notes;
+}
+
+// Notas do MDCT com uma nota igual do FFT a no maximo um frame de distancia, ainda nao usada
+static int count_agreement(const ChartNote* ref, int ref_count, const ChartNote* notes, int count,
+                           double tolerance) {
+    char* used = (char*)calloc(ref_count > 0 ? ref_count : 1, 1);
+    int hits = 0;
+    int first = 0;
+    for (int i = 0; i < count && used; i++) {
+        while (first < ref_count && ref[first].time < notes[i].time - tolerance) first++;
+        for (int j = first; j < ref_count && ref[j].time <= notes[i].time + tolerance; j++) {
+            if (!used[j] && ref[j].note == notes[i].note) {
+                used[j] = 1;
+                hits++;
+                break;
+            }
+        }
+    }
+    free(used);
+    return hits;
+}
+
+// Caminho do criador_mapa padrao: decodifica tudo e analisa em uma thread
+static double time_fft(const char* mp3, AnalysisPlan* plan, double* audio_seconds, int* sample_rate) {
+    double best = 1e9;
+    for (int r = 0; r < REPEATS; r++) {
+        double t0 = now_seconds();
+        AudioData* audio = load_mp3_file(mp3);
+        if (!audio) return -1;
+        analyze_audio_with_plan(audio, BENCH_FFT_OUTPUT, plan);
+        double t = now_seconds() - t0;
+        if (t < best) best = t;
+        *audio_seconds = (double)audio->pcm_size / (audio->channels * audio->sample_rate);
+        *sample_rate = audio->sample_rate;
+        free_audio_data(audio);
+    }
+    return best;
+}
+
+static double time_mdct(const char* mp3, const AnalysisOptions* options) {
+    double best = 1e9;
+    for (int r = 0; r < REPEATS; r++) {
+        double t0 = now_seconds();
+        if (analyze_mdct_to_file(mp3, BENCH_MDCT_OUTPUT, options) != 0) return -1;
+        double t = now_seconds() - t0;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Uso: %s <musica.mp3>...\n", argv[0]);
+        return 1;
+    }
+
+    AnalysisOptions options = ANALYSIS_OPTIONS_DEFAULT;
+    AnalysisPlan* plan = analysis_plan_alloc(&options);
+    double total_fft = 0, total_mdct = 0, total_audio = 0;
+    long total_ref = 0, total_notes = 0, total_hits = 0;
+
+    printf("file,audio_s,fft_s,mdct_s,speedup,fft_notes,mdct_notes,agreement_precision,agreement_recall\n");
+    for (int i = 1; i < argc; i++) {
+        double audio_seconds = 0;
+        int sample_rate = 0;
+        double fft = time_fft(argv[i], plan, &audio_seconds, &sample_rate);
+        double mdct = fft < 0 ? -1 : time_mdct(argv[i], &options);
+        if (fft < 0 || mdct < 0 || sample_rate == 0) {
+            fprintf(stderr, "Ignorando '%s'.\n", argv[i]);
+            continue;
+        }
+
+        int ref_count, count;
+        ChartNote* ref = read_chart(BENCH_FFT_OUTPUT, &ref_count);
+        ChartNote* notes = read_chart(BENCH_MDCT_OUTPUT, &count);
+        int hits = ref && notes ? count_agreement(ref, ref_count, notes, count, (double)FRAME_SIZE / sample_rate) : 0;
+        free(ref);
+        free(notes);
+
+        printf("%s,%.1f,%.4f,%.4f,%.2f,%d,%d,%.4f,%.4f\n", argv[i], audio_seconds, fft, mdct, fft / mdct,
+               ref_count, count, count ? (double)hits / count : 0.0, ref_count ? (double)hits / ref_count : 0.0);
+        total_fft += fft;
+        total_mdct += mdct;
+        total_audio += audio_seconds;
+        total_ref += ref_count;
+        total_notes += count;
+        total_hits += hits;
+    }
+    if (total_mdct > 0) {
+        printf("total,%.1f,%.4f,%.4f,%.2f,%ld,%ld,%.4f,%.4f\n", total_audio, total_fft, total_mdct,
+               total_fft / total_mdct, total_ref, total_notes,
+               total_notes ? (double)total_hits / total_notes : 0.0,
+               total_ref ? (double)total_hits / total_ref : 0.0);
+    }
+
+    analysis_plan_free(plan);
+    remove(BENCH_FFT_OUTPUT);
+    remove(BENCH_MDCT_OUTPUT);
+    return 0;
+}
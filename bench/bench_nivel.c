@@ -0,0 +1,142 @@
+//=======================================================
+// Arquivo: bench_nivel.c
+// Descrição: Compara o tempo de carga de um mapa de 100k
+// notas em texto (o laço fscanf do carregar_nivel) com o
+// mapa compilado (.ghc) carregado via mmap.
+//=======================================================
+
+#include "mapa_compilado.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_NOTES 100000
+#define BENCH_RUNS 20
+#define BENCH_TEXT_FILE "bench_nivel.txt"
+#define BENCH_COMPILED_FILE "bench_nivel.ghc"
+
+// Mesmos campos do GameNote do jogo (guitar_hero.h depende do SDL)
+typedef struct {
+    float timestamp;
+    char note_name[5];
+    int note_index;
+    int foi_processada;
+    int foi_pressionada;
+} BenchNote;
+
+// Um mapa como o do criador_mapa: uma nota nova a cada frame de ~93 ms, sem repetir a anterior
+static void write_text_chart(const char* filename) {
+    FILE* f = fopen(filename, "w");
+    unsigned int seed = 1;
+    int previous = -1;
+    char note_name[5];
+    for (int i = 0; i < BENCH_NOTES; i++) {
+        int note;
+        do {
+            seed = seed * 1103515245 + 12345;
+            note = (seed >> 16) % 48;
+        } while (note == previous);
+        previous = note;
+        chart_note_name(note, note_name);
+        fprintf(f, "%.2f\t%s\n", i * 4096.0 / 44100.0, note_name);
+    }
+    fclose(f);
+}
+
+// Mesmo laço do carregar_nivel
+static int load_text(const char* filename, BenchNote* notes) {
+    FILE* file = fopen(filename, "r");
+    if (!file) return -1;
+    int count = 0;
+    float timestamp;
+    char note_name[5];
+    while (fscanf(file, "%f %s", &timestamp, note_name) == 2) {
+        if (count < BENCH_NOTES) {
+            int pista_mapeada = -1;
+            switch (note_name[0]) {
+                case 'C': case 'D': pista_mapeada = 0; break;
+                case 'E': case 'F': pista_mapeada = 1; break;
+                case 'G': case 'A': pista_mapeada = 2; break;
+                case 'B': pista_mapeada = 3; break;
+            }
+            if (pista_mapeada != -1) {
+                notes[count].timestamp = timestamp;
+                strcpy(notes[count].note_name, note_name);
+                notes[count].note_index = pista_mapeada;
+                notes[count].foi_processada = 0;
+                notes[count].foi_pressionada = 0;
+                count++;
+            }
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+// Mesmo laço do carregar_nivel_compilado
+static int load_compiled(const char* filename, BenchNote* notes) {
+    CompiledChart chart;
+    if (chart_map_compiled(filename, &chart) != 0) return -1;
+    int count = chart.note_count < BENCH_NOTES ? (int)chart.note_count : BENCH_NOTES;
+    for (int i = 0; i < count; i++) {
+        notes[i].timestamp = chart.timestamps[i];
+        chart_note_name(chart.notes[i], notes[i].note_name);
+        notes[i].note_index = chart.lanes[i];
+        notes[i].foi_processada = 0;
+        notes[i].foi_pressionada = 0;
+    }
+    chart_unmap_compiled(&chart);
+    return count;
+}
+
+// Só mapeia e lê as pistas no lugar, sem copiar para o vetor de notas
+static int map_in_place(const char* filename, long* lane_sum) {
+    CompiledChart chart;
+    if (chart_map_compiled(filename, &chart) != 0) return -1;
+    for (uint32_t i = 0; i < chart.note_count; i++) *lane_sum += chart.lanes[i];
+    int count = (int)chart.note_count;
+    chart_unmap_compiled(&chart);
+    return count;
+}
+
+int main(void) {
+    write_text_chart(BENCH_TEXT_FILE);
+    if (chart_compile_text(BENCH_TEXT_FILE, BENCH_COMPILED_FILE) != 0) return -1;
+
+    BenchNote* text_notes = (BenchNote*)malloc(BENCH_NOTES * sizeof(BenchNote));
+    BenchNote* compiled_notes = (BenchNote*)malloc(BENCH_NOTES * sizeof(BenchNote));
+    int text_count = 0, compiled_count = 0, mapped_count = 0;
+    long lane_sum = 0;
+
+    double t0 = now_seconds();
+    for (int r = 0; r < BENCH_RUNS; r++) text_count = load_text(BENCH_TEXT_FILE, text_notes);
+    double t_text = (now_seconds() - t0) / BENCH_RUNS;
+
+    t0 = now_seconds();
+    for (int r = 0; r < BENCH_RUNS; r++) compiled_count = load_compiled(BENCH_COMPILED_FILE, compiled_notes);
+    double t_compiled = (now_seconds() - t0) / BENCH_RUNS;
+
+    t0 = now_seconds();
+    for (int r = 0; r < BENCH_RUNS; r++) mapped_count = map_in_place(BENCH_COMPILED_FILE, &lane_sum);
+    double t_mapped = (now_seconds() - t0) / BENCH_RUNS;
+
+    int iguais = text_count == compiled_count;
+    for (int i = 0; iguais && i < text_count; i++) {
+        iguais = text_notes[i].timestamp == compiled_notes[i].timestamp &&
+                 text_notes[i].note_index == compiled_notes[i].note_index &&
+                 strcmp(text_notes[i].note_name, compiled_notes[i].note_name) == 0;
+    }
+
+    printf("Notas: %d (texto) / %d (compilado), media de %d cargas\n", text_count, compiled_count, BENCH_RUNS);
+    printf("texto (fscanf)         : %8.3f ms\n", t_text * 1e3);
+    printf("compilado (mmap+copia) : %8.3f ms  (%.1fx)\n", t_compiled * 1e3, t_text / t_compiled);
+    printf("compilado (mmap direto): %8.3f ms  (%.1fx, %d notas)\n", t_mapped * 1e3, t_text / t_mapped, mapped_count);
+    printf("Notas identicas: %s\n", iguais ? "sim" : "NAO");
+
+    remove(BENCH_TEXT_FILE);
+    remove(BENCH_COMPILED_FILE);
+    free(text_notes);
+    free(compiled_notes);
+    return iguais ? 0 : -1;
+}
@@ -0,0 +1,93 @@
+//=======================================================
+// Arquivo: bench_pico.c
+// Descrição: Compara o laço escalar original (sqrt por bin)
+// com os kernels de pico do pico_espectral.c (quadrado da
+// magnitude, SSE2 e AVX2) em espectros reais do analisador.
+//=======================================================
+
+#include "kiss_fftr.h"
+#include "pico_espectral.h"
+#include "mapeamento_audio.h"
+#include "bench_util.h"
+
+#define BENCH_FRAMES 512
+#define BENCH_RUNS 20
+#define BENCH_SAMPLE_RATE 44100
+#define BENCH_BINS (FRAME_SIZE / 2 + 1)
+
+// Espectros de frames com um tom por frame mais ruido; alguns frames ficam em silencio
+static kiss_fft_cpx* make_spectra(void) {
+    static const float tones[] = { 110.00, 196.00, 261.63, 329.63, 440.00, 659.25, 880.00 };
+    kiss_fft_cpx* spectra = (kiss_fft_cpx*)malloc((size_t)BENCH_FRAMES * BENCH_BINS * sizeof(kiss_fft_cpx));
+    kiss_fftr_cfg cfg = kiss_fftr_alloc(FRAME_SIZE, 0, NULL, NULL);
+    kiss_fft_scalar in[FRAME_SIZE];
+    unsigned int seed = 1;
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        float freq = tones[f % (sizeof(tones) / sizeof(tones[0]))];
+        float gain = f % 16 == 15 ? 0.0f : 0.5f;
+        for (int i = 0; i < FRAME_SIZE; i++) {
+            seed = seed * 1103515245 + 12345;
+            in[i] = gain * sinf(2.0f * (float)M_PI * freq * i / BENCH_SAMPLE_RATE)
+                  + gain * 0.1f * ((float)((seed >> 16) & 0x7FFF) / 16384.0f - 1.0f);
+        }
+        kiss_fftr(cfg, in, spectra + (size_t)f * BENCH_BINS);
+    }
+    kiss_fftr_free(cfg);
+    return spectra;
+}
+
+// O laço que o detect_frame_note usava
+static int peak_sqrt_loop(const kiss_fft_cpx* out, int first, int end, float* peak_sq) {
+    float max_mag = 0;
+    int max_idx = first;
+    for (int i = first; i < end; i++) {
+        float mag = sqrt(out[i].r * out[i].r + out[i].i * out[i].i);
+        if (mag > max_mag) { max_mag = mag; max_idx = i; }
+    }
+    *peak_sq = max_mag * max_mag;
+    return max_idx;
+}
+
+static double time_kernel(SpectrumPeakFn kernel, const kiss_fft_cpx* spectra, int* peaks) {
+    float peak_sq;
+    double t0 = now_seconds();
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            peaks[f] = kernel(spectra + (size_t)f * BENCH_BINS, 1, FRAME_SIZE / 2, &peak_sq);
+        }
+    }
+    return (now_seconds() - t0) * 1e9 / ((double)BENCH_RUNS * BENCH_FRAMES);
+}
+
+static void report(const char* name, double ns, double base_ns, const int* peaks, const int* base_peaks) {
+    int iguais = 0;
+    for (int f = 0; f < BENCH_FRAMES; f++) iguais += peaks[f] == base_peaks[f];
+    printf("%-18s: %8.1f ns/frame  %5.2fx  picos iguais: %d/%d\n", name, ns, base_ns / ns, iguais, BENCH_FRAMES);
+}
+
+int main(void) {
+    kiss_fft_cpx* spectra = make_spectra();
+    int* base_peaks = (int*)malloc(BENCH_FRAMES * sizeof(int));
+    int* peaks = (int*)malloc(BENCH_FRAMES * sizeof(int));
+
+    printf("Frames: %d x %d bins, kernel escolhido em tempo de execucao: %s\n",
+           BENCH_FRAMES, FRAME_SIZE / 2 - 1, spectrum_peak_kernel_name());
+
+    double base_ns = time_kernel(peak_sqrt_loop, spectra, base_peaks);
+    report("escalar (sqrt)", base_ns, base_ns, base_peaks, base_peaks);
+    report("escalar (quadrado)", time_kernel(spectrum_peak_scalar, spectra, peaks), base_ns, peaks, base_peaks);
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("sse2")) {
+        report("sse2", time_kernel(spectrum_peak_sse2, spectra, peaks), base_ns, peaks, base_peaks);
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        report("avx2", time_kernel(spectrum_peak_avx2, spectra, peaks), base_ns, peaks, base_peaks);
+    }
+#endif
+    report("despachado", time_kernel(spectrum_peak, spectra, peaks), base_ns, peaks, base_peaks);
+
+    free(spectra);
+    free(base_peaks);
+    free(peaks);
+    return 0;
+}
@@ -0,0 +1,62 @@
+//=======================================================
+// Arquivo: bench_stft.c
+// Descrição: Mede frames/s do analisador (janela + FFT +
+// pico) para cada hop e janela da STFT, em 30 s de audio
+// estereo sintetico.
+//=======================================================
+
+#include "mapeamento_audio.h"
+#include "bench_util.h"
+
+#define BENCH_SECONDS 30
+#define BENCH_SAMPLE_RATE 44100
+#define BENCH_OUTPUT "bench_stft.txt"
+
+// Estereo com uma nota nova a cada 250 ms, mais ruido
+static AudioData* make_audio(void) {
+    AudioData* audio = (AudioData*)malloc(sizeof(AudioData));
+    size_t frames = (size_t)BENCH_SECONDS * BENCH_SAMPLE_RATE;
+    audio->pcm_buffer = (short*)malloc(frames * 2 * sizeof(short));
+    audio->pcm_size = frames * 2;
+    audio->sample_rate = BENCH_SAMPLE_RATE;
+    audio->channels = 2;
+    bench_tones(audio->pcm_buffer, frames, 2, BENCH_SAMPLE_RATE, BENCH_SAMPLE_RATE / 4);
+    return audio;
+}
+
+int main(void) {
+    static const int hops[] = { 4096, 2048, 1024, 512, 256 };
+    static const WindowType windows[] = { WINDOW_RECTANGULAR, WINDOW_HANN, WINDOW_BLACKMAN };
+    static const char* const window_names[] = { "rect", "hann", "blackman" };
+    AudioData* audio = make_audio();
+    long window_size = FRAME_SIZE * audio->channels;
+
+    printf("Audio: %d s estereo a %d Hz, janela de %d amostras\n", BENCH_SECONDS, BENCH_SAMPLE_RATE, FRAME_SIZE);
+    printf("%-9s %5s %9s %8s %10s %12s %8s\n", "janela", "hop", "passo ms", "frames", "frames/s", "x tempo real", "notas");
+    for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        for (size_t h = 0; h < sizeof(hops) / sizeof(hops[0]); h++) {
+            AnalysisOptions options = ANALYSIS_OPTIONS_DEFAULT;
+            options.window = windows[w];
+            options.hop_size = hops[h];
+            AnalysisPlan* plan = analysis_plan_alloc(&options);
+
+            double t0 = now_seconds();
+            analyze_audio_with_plan(audio, BENCH_OUTPUT, plan);
+            double elapsed = now_seconds() - t0;
+            analysis_plan_free(plan);
+
+            long frames = ((long)audio->pcm_size - window_size - 1) / (hops[h] * audio->channels) + 1;
+            int notas = 0;
+            FILE* f = fopen(BENCH_OUTPUT, "r");
+            for (int c; f && (c = fgetc(f)) != EOF; ) notas += c == '\n';
+            if (f) fclose(f);
+
+            printf("%-9s %5d %9.1f %8ld %10.0f %12.1f %8d\n", window_names[w], hops[h],
+                   hops[h] * 1000.0 / BENCH_SAMPLE_RATE, frames, frames / elapsed, BENCH_SECONDS / elapsed, notas);
+        }
+    }
+
+    remove(BENCH_OUTPUT);
+    free_audio_data(audio);
+    return 0;
+}
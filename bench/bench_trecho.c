@@ -0,0 +1,112 @@
+//=======================================================
+// Arquivo: bench_trecho.c
+// Descrição: Mede o custo de remapear so um trecho de
+// cada musica (--inicio/--fim, via indice de frames) em
+// comparacao com o mapa da musica inteira: tempo do
+// indice, do mapa completo e de trechos de 10 s no
+// comeco, meio e fim, e se as notas do trecho sao as do
+// mapa completo. Saida em CSV, uma linha por trecho:
+//   ./bench_trecho musicas/*.mp3 > trecho.csv
+//=======================================================
+
+#include "mapeamento_audio.h"
+#include "indice_mp3.h"
+#include "bench_util.h"
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_FULL_OUTPUT "bench_trecho_completo.txt"
+#define BENCH_RANGE_OUTPUT "bench_trecho.txt"
+#define SECTION_SECONDS 10.0
+#define REPEATS 3             // vale o melhor tempo
+
+static double time_chart(const char* mp3, const char* output, const AnalysisOptions* options) {
+    double best = 1e9;
+    for (int r = 0; r < REPEATS; r++) {
+        double t0 = now_seconds();
+        if (analyze_mp3_to_file(mp3, output, options) != 0) return -1;
+        double t = now_seconds() - t0;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+// So a construcao, sobre o MP3 ja mapeado (o criador_mapa paga isso uma vez por musica)
+static double time_index(const Mp3Source* source) {
+    double best = 1e9;
+    for (int r = 0; r < REPEATS; r++) {
+        double t0 = now_seconds();
+        Mp3Index* index = mp3_index_build(source->mp3, source->mp3_size);
+        double t = now_seconds() - t0;
+        mp3_index_free(index);
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+// Fracao das linhas do trecho que aparecem iguais, e na mesma ordem, no mapa completo
+static double section_agreement(void) {
+    FILE* full = fopen(BENCH_FULL_OUTPUT, "r");
+    FILE* range = fopen(BENCH_RANGE_OUTPUT, "r");
+    if (!full || !range) {
+        if (full) fclose(full);
+        if (range) fclose(range);
+        return 0;
+    }
+    char wanted[64], line[64];
+    int total = 0, found = 0;
+    while (fgets(wanted, sizeof(wanted), range)) {
+        total++;
+        while (fgets(line, sizeof(line), full)) {
+            if (strcmp(line, wanted) == 0) {
+                found++;
+                break;
+            }
+        }
+    }
+    fclose(full);
+    fclose(range);
+    return total > 0 ? (double)found / total : 1.0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Uso: %s <musica.mp3>...\n", argv[0]);
+        return -1;
+    }
+
+    // O analisador escreve o andamento em stdout: o CSV vai por uma copia do descritor
+    FILE* csv = fdopen(dup(STDOUT_FILENO), "w");
+    if (!csv || !freopen("/dev/null", "w", stdout)) return -1;
+    fprintf(csv, "arquivo,duracao_s,indice_s,completo_s,trecho_inicio_s,trecho_s,razao,notas_conferem\n");
+
+    for (int i = 1; i < argc; i++) {
+        Mp3Source source;
+        if (mp3_source_open(&source, argv[i]) != 0) continue;
+        const Mp3FrameEntry* frames = source.index->frames;
+        long count = source.index->frame_count;
+        double duration = count > 0 ? (double)frames[count].pcm_offset / (frames[0].hz * frames[0].channels) : 0;
+        double index_s = time_index(&source);
+        mp3_source_close(&source);
+
+        AnalysisOptions options = ANALYSIS_OPTIONS_DEFAULT;
+        double full_s = time_chart(argv[i], BENCH_FULL_OUTPUT, &options);
+        if (full_s < 0 || duration < SECTION_SECONDS) continue;
+
+        double starts[3] = { 0, (duration - SECTION_SECONDS) / 2, duration - SECTION_SECONDS };
+        for (int s = 0; s < 3; s++) {
+            options.start_seconds = starts[s];
+            options.end_seconds = starts[s] + SECTION_SECONDS;
+            double range_s = time_chart(argv[i], BENCH_RANGE_OUTPUT, &options);
+            if (range_s < 0) continue;
+            fprintf(csv, "%s,%.1f,%.4f,%.4f,%.1f,%.4f,%.3f,%.3f\n", argv[i], duration, index_s, full_s,
+                    starts[s], range_s, range_s / full_s, section_agreement());
+        }
+        fflush(csv);
+    }
+
+    remove(BENCH_FULL_OUTPUT);
+    remove(BENCH_RANGE_OUTPUT);
+    fclose(csv);
+    return 0;
+}
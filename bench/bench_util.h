@@ -0,0 +1,75 @@
+//=======================================================
+// Arquivo: bench_util.h
+// Descrição: O que os benchmarks de bench/ compartilham:
+// o relogio monotonico e os sinais sinteticos (a escala
+// de tons com ruido e a musica de gabarito conhecido do
+// bench_analise). So funcoes inline, sem .c para ligar.
+//=======================================================
+
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+typedef struct {
+    float time;
+    int note;
+} TruthNote;
+
+static inline double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Sete tons de 110 a 880 Hz, um novo a cada step quadros, com ruido; o mesmo valor em
+// todos os canais
+static inline void bench_tones(short* pcm, size_t frames, int channels, int sample_rate, size_t step) {
+    static const float tones[] = { 110.00, 196.00, 261.63, 329.63, 440.00, 659.25, 880.00 };
+    unsigned int seed = 1;
+    for (size_t i = 0; i < frames; i++) {
+        float freq = tones[(i / step) % (sizeof(tones) / sizeof(tones[0]))];
+        float v = 0.5f * sinf(2.0f * (float)M_PI * freq * i / sample_rate);
+        seed = seed * 1103515245 + 12345;
+        v += 0.05f * ((float)((seed >> 16) & 0x7FFF) / 16384.0f - 1.0f);
+        for (int c = 0; c < channels; c++) pcm[i * channels + c] = (short)(v * 32767.0f);
+    }
+}
+
+// Sequencia de notas da escala do analisador (0 = C2, 33 = A4, num_notes notas) sem
+// repeticoes seguidas (o analisador funde notas iguais consecutivas), cada uma com
+// note_seconds, um seno com dois harmonicos e ruido e ataque curto para nao estalar.
+// truth recebe o inicio e a nota de cada uma
+static inline void bench_truth_song(short* pcm, size_t frames, int channels, int sample_rate, double note_seconds,
+                                    int num_notes, TruthNote* truth, int* truth_count) {
+    unsigned int seed = 12345;
+    size_t note_frames = (size_t)(note_seconds * sample_rate);
+    int note = -1;
+    *truth_count = 0;
+    double phase = 0;
+    for (size_t i = 0; i < frames; i++) {
+        size_t pos = i % note_frames;
+        if (pos == 0) {
+            int next;
+            do {
+                seed = seed * 1103515245 + 12345;
+                next = (seed >> 16) % num_notes;
+            } while (next == note);
+            note = next;
+            truth[*truth_count].time = (float)i / sample_rate;
+            truth[*truth_count].note = note;
+            (*truth_count)++;
+        }
+        double freq = 440.0 * pow(2.0, (note - 33) / 12.0);
+        phase += 2.0 * M_PI * freq / sample_rate;
+        double attack = pos < 64 ? pos / 64.0 : 1.0;
+        double v = attack * (0.5 * sin(phase) + 0.15 * sin(2 * phase) + 0.05 * sin(3 * phase));
+        seed = seed * 1103515245 + 12345;
+        v += 0.03 * ((double)((seed >> 16) & 0x7FFF) / 16384.0 - 1.0);
+        for (int c = 0; c < channels; c++) pcm[i * channels + c] = (short)(v * 32767.0);
+    }
+}
+
+#endif
@@ -0,0 +1,177 @@
+// minimp3 once more, for its Layer III front half only. The public functions are renamed
+// so this translation unit links next to the PCM decoders.
+#define MINIMP3_IMPLEMENTATION
+#define mp3dec_init mp3dec_init_mdct
+#define mp3dec_decode_frame mp3dec_decode_frame_mdct
+#include "minimp3.h"
+#include "analise_mdct.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct MdctReader {
+    unsigned char* mp3;
+    long size;
+    long pos;
+    int sample_rate;
+    int granules;        // decoded granules waiting in power
+    int next_granule;
+    mp3dec_t dec;
+    mp3dec_scratch_t scratch;
+    float power[2][MDCT_GRANULE_LINES];
+};
+
+MdctReader* mdct_reader_open(const char* filename) {
+    FILE* f = fopen(filename, "rb");
+    if (!f) {
+        printf("Erro ao abrir o arquivo '%s'!\n", filename);
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    MdctReader* reader = (MdctReader*)malloc(sizeof(MdctReader));
+    unsigned char* mp3 = (unsigned char*)malloc(file_size);
+    if (!reader || !mp3) {
+        printf("Erro ao alocar memoria para o buffer do MP3.\n");
+        free(reader);
+        free(mp3);
+        fclose(f);
+        return NULL;
+    }
+    if (fread(mp3, 1, file_size, f) != (size_t)file_size) {
+        printf("Erro ao ler o arquivo MP3 para o buffer.\n");
+        free(reader);
+        free(mp3);
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+
+    reader->mp3 = mp3;
+    reader->size = file_size;
+    reader->pos = 0;
+    reader->sample_rate = 0;
+    reader->granules = 0;
+    reader->next_granule = 0;
+    mp3dec_init(&reader->dec);
+    return reader;
+}
+
+void mdct_reader_close(MdctReader* reader) {
+    if (!reader) return;
+    free(reader->mp3);
+    free(reader);
+}
+
+int mdct_reader_sample_rate(const MdctReader* reader) {
+    return reader->sample_rate;
+}
+
+// The first half of L3_decode (scalefactors, Huffman + requantization, stereo), then the
+// power of each line instead of L3_reorder/L3_antialias/L3_imdct_gr
+static void mdct_granule_power(mp3dec_t* h, mp3dec_scratch_t* s, const L3_gr_info_t* gr_info, int nch, float* power) {
+    int ch;
+
+    for (ch = 0; ch < nch; ch++) {
+        int layer3gr_limit = s->bs.pos + gr_info[ch].part_23_length;
+        L3_decode_scalefactors(h->header, s->ist_pos[ch], &s->bs, gr_info + ch, s->scf, ch);
+        L3_huffman(s->grbuf[ch], &s->bs, gr_info + ch, s->scf, layer3gr_limit);
+    }
+
+    if (HDR_TEST_I_STEREO(h->header)) {
+        L3_intensity_stereo(s->grbuf[0], s->ist_pos[1], gr_info, h->header);
+    } else if (HDR_IS_MS_STEREO(h->header)) {
+        L3_midside_stereo(s->grbuf[0], 576);
+    }
+
+    memset(power, 0, MDCT_GRANULE_LINES * sizeof(float));
+    for (ch = 0; ch < nch; ch++, gr_info++) {
+        const float* lines = s->grbuf[ch];
+        int n_long_lines = MDCT_GRANULE_LINES;
+        if (gr_info->n_short_sfb) {
+            n_long_lines = 18 * ((gr_info->mixed_block_flag ? 2 : 0) << (int)(HDR_GET_MY_SAMPLE_RATE(h->header) == 2));
+        }
+        for (int i = 0; i < n_long_lines; i++) power[i] += lines[i] * lines[i];
+        if (!gr_info->n_short_sfb) continue;
+
+        // Short blocks are stored band by band as [window][line]; short line j spans
+        // long lines 3j..3j+2
+        const uint8_t* sfb = gr_info->sfbtab + gr_info->n_long_sfb;
+        const float* src = lines + n_long_lines;
+        int line = n_long_lines / 3;
+        for (int len; 0 != (len = *sfb); sfb += 3, src += 3 * len, line += len) {
+            for (int k = 0; k < len; k++) {
+                float p = (src[k] * src[k] + src[len + k] * src[len + k] + src[2*len + k] * src[2*len + k]) * (1.0f / 3);
+                float* dst = power + (line + k) * 3;
+                dst[0] += p;
+                dst[1] += p;
+                dst[2] += p;
+            }
+        }
+    }
+}
+
+// Frame sync and bit reservoir exactly as in mp3dec_decode_frame, so the granules line up
+// with the PCM the other analyzers see. Returns the number of granules decoded.
+static int mdct_reader_decode_frame(MdctReader* reader) {
+    mp3dec_t* dec = &reader->dec;
+    mp3dec_scratch_t* s = &reader->scratch;
+    const uint8_t* mp3 = reader->mp3 + reader->pos;
+    int mp3_bytes = (int)(reader->size - reader->pos);
+    int i = 0, frame_size = 0;
+
+    if (mp3_bytes > 4 && dec->header[0] == 0xff && hdr_compare(dec->header, mp3)) {
+        frame_size = hdr_frame_bytes(mp3, dec->free_format_bytes) + hdr_padding(mp3);
+        if (frame_size != mp3_bytes && (frame_size + HDR_SIZE > mp3_bytes || !hdr_compare(mp3, mp3 + frame_size))) {
+            frame_size = 0;
+        }
+    }
+    if (!frame_size) {
+        memset(dec, 0, sizeof(mp3dec_t));
+        i = mp3d_find_frame(mp3, mp3_bytes, &dec->free_format_bytes, &frame_size);
+        if (!frame_size || i + frame_size > mp3_bytes) return 0;
+    }
+
+    const uint8_t* hdr = mp3 + i;
+    memcpy(dec->header, hdr, HDR_SIZE);
+    reader->pos += i + frame_size;
+    if (4 - HDR_GET_LAYER(hdr) != 3) return -1;
+    int channels = HDR_IS_MONO(hdr) ? 1 : 2;
+    reader->sample_rate = hdr_sample_rate_hz(hdr);
+
+    bs_t bs_frame[1];
+    bs_init(bs_frame, hdr + HDR_SIZE, frame_size - HDR_SIZE);
+    if (HDR_IS_CRC(hdr)) {
+        get_bits(bs_frame, 16);
+    }
+
+    int main_data_begin = L3_read_side_info(bs_frame, s->gr_info, hdr);
+    if (main_data_begin < 0 || bs_frame->pos > bs_frame->limit) {
+        mp3dec_init(dec);
+        return 0;
+    }
+    int granules = 0;
+    if (L3_restore_reservoir(dec, bs_frame, s, main_data_begin)) {
+        granules = HDR_TEST_MPEG1(hdr) ? 2 : 1;
+        for (int igr = 0; igr < granules; igr++) {
+            memset(s->grbuf[0], 0, 576*2*sizeof(float));
+            mdct_granule_power(dec, s, s->gr_info + igr*channels, channels, reader->power[igr]);
+        }
+    }
+    L3_save_reservoir(dec, s);
+    return granules;
+}
+
+int mdct_reader_next(MdctReader* reader, float* power) {
+    if (reader->next_granule == reader->granules) {
+        int granules = mdct_reader_decode_frame(reader);
+        if (granules <= 0) return granules;
+        reader->granules = granules;
+        reader->next_granule = 0;
+    }
+    memcpy(power, reader->power[reader->next_granule++], MDCT_GRANULE_LINES * sizeof(float));
+    return 1;
+}
@@ -0,0 +1,21 @@
+#ifndef ANALISE_MDCT_H
+#define ANALISE_MDCT_H
+
+#define MDCT_GRANULE_LINES 576   // spectral lines per Layer III granule (and PCM samples it yields)
+
+// Reads the spectral lines an MP3 already stores instead of its PCM: each granule stops after
+// requantization and stereo processing, so the antialias butterflies, the IMDCT and the
+// polyphase synthesis never run. Line i is centred at (i + 0.5) * sample_rate / 1152 Hz.
+typedef struct MdctReader MdctReader;
+
+MdctReader* mdct_reader_open(const char* filename);   // NULL on error (message printed)
+
+// Power of the next granule's lines, summed over the channels. Short-block granules have
+// their three windows summed, and each of the 192 short lines is spread over the three long
+// lines it covers. Returns 1, 0 at the end (where mp3dec_decode_frame would stop as well)
+// or -1 if the stream is not Layer III.
+int mdct_reader_next(MdctReader* reader, float* power);
+int mdct_reader_sample_rate(const MdctReader* reader);   // 0 until the first granule
+void mdct_reader_close(MdctReader* reader);
+
+#endif // ANALISE_MDCT_H
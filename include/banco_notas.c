@@ -0,0 +1,220 @@
+#include "banco_notas.h"
+#include "mapeamento_audio.h"
+#include <string.h>
+#include <pthread.h>
+#define BANK_LANES 32   // Goertzel resonators run together: enough independent chains to hide latency
+
+struct NoteBank {
+    int size;
+    int first;             // lowest note bin
+    int count;             // note bins first..first + count
+    int padded;            // count rounded up to BANK_LANES (extra bins are computed, never peaked)
+    WindowType window;
+    int margin;            // neighbours on each side the sliding DFT's window needs
+    float* coef;           // padded: 2 cos(2 pi k / size)
+    float* power;          // padded
+    // Sliding DFT over bins first - margin .. first + count + margin
+    int span;
+    double* re;
+    double* im;
+    double* rot_re;        // e^(j 2 pi k / size)
+    double* rot_im;
+    float* ring;           // the window's mono samples, oldest at ring_pos
+    int ring_pos;
+    float* rect;           // window_build's rectangular window: int16 scale and downmix
+    float* fresh;          // the hop's new mono samples
+    int channels;
+    size_t bytes;          // the single block note_bank_alloc made
+};
+
+NoteBank* note_bank_alloc(const signed char* bin_notes, int size, WindowType window, int channels) {
+    int margin = window == WINDOW_BLACKMAN ? 2 : window == WINDOW_HANN ? 1 : 0;
+    int first = -1, last = -1;
+    for (int k = 1; k < size / 2; k++) {
+        if (bin_notes[k] == NOTE_NONE) continue;
+        if (first < 0) first = k;
+        last = k;
+    }
+    if (first < margin) first = margin;
+    int count = last >= first ? last - first + 1 : 0;
+    int padded = (count + BANK_LANES - 1) / BANK_LANES * BANK_LANES;
+    int span = count + 2 * margin;
+
+    // One zeroed block: the context, then the double arrays, then the float ones
+    size_t doubles = 4 * (size_t)(span + 1);
+    size_t floats = 2 * (size_t)(padded + 1) + 3 * (size_t)size;
+    size_t bytes = sizeof(NoteBank) + doubles * sizeof(double) + floats * sizeof(float);
+    NoteBank* bank = (NoteBank*)calloc(1, bytes);
+    if (!bank) return NULL;
+    bank->bytes = bytes;
+    bank->size = size;
+    bank->window = window;
+    bank->channels = channels;
+    bank->margin = margin;
+    bank->first = first;
+    bank->count = count;
+    bank->padded = padded;
+    bank->span = span;
+
+    bank->re = (double*)(bank + 1);
+    bank->im = bank->re + span + 1;
+    bank->rot_re = bank->im + span + 1;
+    bank->rot_im = bank->rot_re + span + 1;
+    bank->coef = (float*)(bank->rot_im + span + 1);
+    bank->power = bank->coef + padded + 1;
+    bank->ring = bank->power + padded + 1;
+    bank->rect = bank->ring + size;
+    bank->fresh = bank->rect + size;
+
+    for (int b = 0; b < bank->padded; b++) {
+        bank->coef[b] = (float)(2.0 * cos(2.0 * M_PI * (first + b) / size));
+    }
+    for (int b = 0; b < bank->span; b++) {
+        double phase = 2.0 * M_PI * (first - bank->margin + b) / size;
+        bank->rot_re[b] = cos(phase);
+        bank->rot_im[b] = sin(phase);
+    }
+    window_build(bank->rect, size, WINDOW_RECTANGULAR, channels);
+    return bank;
+}
+
+void note_bank_free(NoteBank* bank) {
+    free(bank);
+}
+
+size_t note_bank_bytes(const NoteBank* bank) {
+    return bank ? bank->bytes : 0;
+}
+
+// s[n] = x[n] + 2 cos(w) s[n-1] - s[n-2] for BANK_LANES bins at a time; after the frame,
+// |X|^2 = s1^2 + s2^2 - 2 cos(w) s1 s2. Lanes only ever combine with themselves, so the
+// vectorized builds round exactly like the scalar one.
+static inline __attribute__((always_inline))
+void goertzel_body(const float* coef, float* power, int padded, const float* frame, int size) {
+    for (int b = 0; b < padded; b += BANK_LANES) {
+        float c[BANK_LANES], s1[BANK_LANES], s2[BANK_LANES];
+        for (int l = 0; l < BANK_LANES; l++) {
+            c[l] = coef[b + l];
+            s1[l] = 0;
+            s2[l] = 0;
+        }
+        for (int n = 0; n < size; n++) {
+            float x = frame[n];
+            for (int l = 0; l < BANK_LANES; l++) {
+                float s0 = x + c[l] * s1[l] - s2[l];
+                s2[l] = s1[l];
+                s1[l] = s0;
+            }
+        }
+        for (int l = 0; l < BANK_LANES; l++) {
+            power[b + l] = s1[l] * s1[l] + s2[l] * s2[l] - c[l] * s1[l] * s2[l];
+        }
+    }
+}
+
+// X_k <- (X_k + x_new - x_old) e^(j 2 pi k / size) for every bin, per new sample
+static inline __attribute__((always_inline))
+void slide_body(double* re, double* im, const double* rot_re, const double* rot_im, int span,
+                float* ring, int* ring_pos, int size, const float* fresh, int count) {
+    int pos = *ring_pos;
+    for (int n = 0; n < count; n++) {
+        double d = (double)fresh[n] - ring[pos];
+        ring[pos] = fresh[n];
+        if (++pos == size) pos = 0;
+        for (int b = 0; b < span; b++) {
+            double r = re[b] + d;
+            double i = im[b];
+            re[b] = r * rot_re[b] - i * rot_im[b];
+            im[b] = r * rot_im[b] + i * rot_re[b];
+        }
+    }
+    *ring_pos = pos;
+}
+
+static void goertzel_generic(const float* coef, float* power, int padded, const float* frame, int size) {
+    goertzel_body(coef, power, padded, frame, size);
+}
+
+static void slide_generic(double* re, double* im, const double* rot_re, const double* rot_im, int span,
+                          float* ring, int* ring_pos, int size, const float* fresh, int count) {
+    slide_body(re, im, rot_re, rot_im, span, ring, ring_pos, size, fresh, count);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Same C, compiled for AVX2 (no FMA, which would round differently)
+__attribute__((target("avx2")))
+static void goertzel_avx2(const float* coef, float* power, int padded, const float* frame, int size) {
+    goertzel_body(coef, power, padded, frame, size);
+}
+
+__attribute__((target("avx2")))
+static void slide_avx2(double* re, double* im, const double* rot_re, const double* rot_im, int span,
+                       float* ring, int* ring_pos, int size, const float* fresh, int count) {
+    slide_body(re, im, rot_re, rot_im, span, ring, ring_pos, size, fresh, count);
+}
+
+#endif
+
+typedef void (*GoertzelFn)(const float*, float*, int, const float*, int);
+typedef void (*SlideFn)(double*, double*, const double*, const double*, int, float*, int*, int, const float*, int);
+
+static GoertzelFn goertzel_kernel = goertzel_generic;
+static SlideFn slide_kernel = slide_generic;
+static pthread_once_t bank_kernel_once = PTHREAD_ONCE_INIT;
+
+static void select_bank_kernels(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        goertzel_kernel = goertzel_avx2;
+        slide_kernel = slide_avx2;
+    }
+#endif
+}
+
+static int bank_peak(const NoteBank* bank, float* peak_sq) {
+    float max_sq = 0;
+    int max_idx = 0;
+    for (int b = 0; b < bank->count; b++) {
+        if (bank->power[b] > max_sq) { max_sq = bank->power[b]; max_idx = b; }
+    }
+    *peak_sq = max_sq;
+    return bank->first + max_idx;
+}
+
+int note_bank_block_peak(NoteBank* bank, const float* frame, float* peak_sq) {
+    pthread_once(&bank_kernel_once, select_bank_kernels);
+    goertzel_kernel(bank->coef, bank->power, bank->padded, frame, bank->size);
+    return bank_peak(bank, peak_sq);
+}
+
+int note_bank_slide_peak(NoteBank* bank, const short* frame, int count, float* peak_sq) {
+    pthread_once(&bank_kernel_once, select_bank_kernels);
+    if (count >= bank->size) {
+        count = bank->size;
+        memset(bank->re, 0, bank->span * sizeof(double));
+        memset(bank->im, 0, bank->span * sizeof(double));
+        memset(bank->ring, 0, bank->size * sizeof(float));
+        bank->ring_pos = 0;
+    }
+    window_apply(frame + (bank->size - count) * bank->channels, bank->channels, bank->rect, bank->fresh, count);
+    slide_kernel(bank->re, bank->im, bank->rot_re, bank->rot_im, bank->span, bank->ring, &bank->ring_pos,
+                 bank->size, bank->fresh, count);
+
+    // Hann and Blackman as sums of cosines: neighbouring bins, normalized like window_build
+    const double* re = bank->re + bank->margin;
+    const double* im = bank->im + bank->margin;
+    for (int b = 0; b < bank->count; b++) {
+        double r = re[b], i = im[b];
+        if (bank->window == WINDOW_HANN) {
+            r -= 0.5 * (re[b - 1] + re[b + 1]);
+            i -= 0.5 * (im[b - 1] + im[b + 1]);
+        } else if (bank->window == WINDOW_BLACKMAN) {
+            r -= (0.25 * (re[b - 1] + re[b + 1]) - 0.04 * (re[b - 2] + re[b + 2])) / 0.42;
+            i -= (0.25 * (im[b - 1] + im[b + 1]) - 0.04 * (im[b - 2] + im[b + 2])) / 0.42;
+        }
+        bank->power[b] = (float)(r * r + i * i);
+    }
+    return bank_peak(bank, peak_sq);
+}
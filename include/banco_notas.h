@@ -0,0 +1,32 @@
+#ifndef BANCO_NOTAS_H
+#define BANCO_NOTAS_H
+
+#include "janela.h"
+
+// The DFT bins of a size-point frame that can hold a note (from the lowest to the highest
+// bin with bin_notes[k] != NOTE_NONE, ~90 at 44.1 kHz against the FFT's 2049), evaluated
+// on their own instead of with a full FFT. Two ways, both giving the FFT's |X[k]|^2 on
+// the same scale, so THRESHOLD and the bin -> note table apply unchanged:
+//  - block: a Goertzel resonator per bin over one windowed frame, any hop;
+//  - sliding DFT: the bins of the last size samples, updated per sample as the hop's new
+//    samples arrive, so a window costs hop * bins instead of a whole transform. Hann and
+//    Blackman are applied in the frequency domain through the neighbouring bins.
+// The per-bin loops are laid out bin by bin so they vectorize, with an AVX2 build picked
+// at run time where the CPU has it. Each kernel gives the same floats on every path.
+typedef struct NoteBank NoteBank;
+
+// channels sets the int16 scale and downmix of the sliding DFT's input (window_build's)
+NoteBank* note_bank_alloc(const signed char* bin_notes, int size, WindowType window, int channels);
+void note_bank_free(NoteBank* bank);
+size_t note_bank_bytes(const NoteBank* bank);   // the single block note_bank_alloc made
+
+// Block mode on one frame already windowed with window_apply, as for the FFT. Returns the
+// bin with the largest magnitude (ties: the lowest) and its squared magnitude in *peak_sq.
+int note_bank_block_peak(NoteBank* bank, const float* frame, float* peak_sq);
+
+// Sliding mode: the window now ends `count` samples later. frame is the window's interleaved
+// PCM (size frames); only its last count samples are read. count == size restarts from this
+// window alone. Returns the peak like note_bank_block_peak.
+int note_bank_slide_peak(NoteBank* bank, const short* frame, int count, float* peak_sq);
+
+#endif // BANCO_NOTAS_H
@@ -0,0 +1,105 @@
+#include "cache_mapas.h"
+#include "mapeamento_audio.h"
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t fnv1a(uint64_t hash, const unsigned char* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+int chart_cache_key(const char* mp3_filename, const char* settings, char* key) {
+    int fd = open(mp3_filename, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    char params[128];
+    snprintf(params, sizeof(params), "%d|%g|%d|%s", FRAME_SIZE, THRESHOLD, NOTE_DETECTOR_VERSION,
+             settings ? settings : "");
+    uint64_t hash = fnv1a(FNV_OFFSET, (const unsigned char*)params, strlen(params));
+
+    if (st.st_size > 0) {
+        void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+        hash = fnv1a(hash, (const unsigned char*)data, st.st_size);
+        munmap(data, st.st_size);
+    }
+    close(fd);
+
+    snprintf(key, CHART_CACHE_KEY_SIZE, "%016llx", (unsigned long long)hash);
+    return 0;
+}
+
+static int copy_file(const char* from, const char* to) {
+    FILE* in = fopen(from, "rb");
+    if (!in) return -1;
+    FILE* out = fopen(to, "wb");
+    if (!out) {
+        fclose(in);
+        return -1;
+    }
+    char buffer[64 * 1024];
+    size_t got;
+    int result = 0;
+    while ((got = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        if (fwrite(buffer, 1, got, out) != got) {
+            result = -1;
+            break;
+        }
+    }
+    if (ferror(in)) result = -1;
+    fclose(in);
+    if (fclose(out) != 0) result = -1;
+    return result;
+}
+
+int chart_cache_fetch(const char* key, const char* chart_filename, double* analysis_seconds) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.meta", CHART_CACHE_DIR, key);
+    FILE* meta = fopen(path, "r");
+    if (!meta) return -1;
+    // The .meta is written last, so an entry without one is incomplete and counts as a miss
+    int ok = fscanf(meta, "%lf", analysis_seconds) == 1;
+    fclose(meta);
+    if (!ok) return -1;
+
+    snprintf(path, sizeof(path), "%s/%s.txt", CHART_CACHE_DIR, key);
+    return copy_file(path, chart_filename);
+}
+
+int chart_cache_store(const char* key, const char* chart_filename, double analysis_seconds) {
+    char path[256], tmp[256];
+    mkdir(CHART_CACHE_DIR, 0755);
+
+    // Copy to a temporary name first: a game killed mid-copy never leaves a truncated chart
+    snprintf(tmp, sizeof(tmp), "%s/%s.tmp", CHART_CACHE_DIR, key);
+    snprintf(path, sizeof(path), "%s/%s.txt", CHART_CACHE_DIR, key);
+    if (copy_file(chart_filename, tmp) != 0 || rename(tmp, path) != 0) {
+        printf("Erro ao gravar o mapa no cache '%s'!\n", CHART_CACHE_DIR);
+        remove(tmp);
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "%s/%s.meta", CHART_CACHE_DIR, key);
+    FILE* meta = fopen(path, "w");
+    if (!meta) return -1;
+    fprintf(meta, "%.6f\n", analysis_seconds);
+    fclose(meta);
+    return 0;
+}
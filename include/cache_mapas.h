@@ -0,0 +1,21 @@
+#ifndef CACHE_MAPAS_H
+#define CACHE_MAPAS_H
+
+// Chart cache: charts are stored under CHART_CACHE_DIR, keyed by a hash of the MP3 bytes
+// plus everything that changes the analyzer's output (FRAME_SIZE, THRESHOLD,
+// NOTE_DETECTOR_VERSION and the caller's settings), so a known song is never re-analyzed.
+#define CHART_CACHE_DIR ".cache_mapas"
+#define CHART_CACHE_KEY_SIZE 17   // 16 hex digits + '\0'
+
+// Hashes mp3_filename into key. settings describes non-default analysis options
+// (NULL for the defaults). Returns -1 if the MP3 can't be read.
+int chart_cache_key(const char* mp3_filename, const char* settings, char* key);
+
+// On a hit, copies the cached chart to chart_filename and returns 0; *analysis_seconds
+// gets how long the analysis took when the chart was stored. Returns -1 on a miss.
+int chart_cache_fetch(const char* key, const char* chart_filename, double* analysis_seconds);
+
+// Stores chart_filename under key, with the time its analysis took. Returns 0 on success.
+int chart_cache_store(const char* key, const char* chart_filename, double analysis_seconds);
+
+#endif // CACHE_MAPAS_H
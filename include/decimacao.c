@@ -0,0 +1,164 @@
+#include "decimacao.h"
+#include "janela.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#define TAPS_PER_PHASE 16          // FIR length = TAPS_PER_PHASE * factor
+#define DOWNMIX_BLOCK 4096
+
+int decimation_factor_for_rate(int sample_rate) {
+    int factor = 1;
+    while (factor < 16 && sample_rate / (factor * 2) >= 4000) factor *= 2;
+    return factor;
+}
+
+// Blackman-windowed sinc with the cutoff at 80% of the output Nyquist, stored reversed
+// so each output is a plain dot product with the input that ends at its position
+static float* design_lowpass(int factor, int taps) {
+    float* h = (float*)malloc(taps * sizeof(float));
+    if (!h) return NULL;
+    double cutoff = 0.8 * 0.5 / factor;   // cycles per input sample
+    double center = (taps - 1) / 2.0;
+    double sum = 0;
+    for (int i = 0; i < taps; i++) {
+        double x = i - center;
+        double sinc = x == 0 ? 2 * cutoff : sin(2 * M_PI * cutoff * x) / (M_PI * x);
+        double w = 0.42 - 0.5 * cos(2 * M_PI * i / (taps - 1)) + 0.08 * cos(4 * M_PI * i / (taps - 1));
+        h[taps - 1 - i] = (float)(sinc * w);
+        sum += sinc * w;
+    }
+    for (int i = 0; i < taps; i++) h[i] = (float)(h[i] / sum);   // unity gain at DC
+    return h;
+}
+
+// Every kernel sums in this order, so every path gives the same floats and --decimar charts
+// don't depend on the CPU: eight running sums, lane l over taps l, l + 8, ..., each product
+// rounded before it is added (no FMA), then lane l + lane l + 4, then the pairs.
+// taps is a multiple of 8 (TAPS_PER_PHASE * a power of two).
+static float dot_scalar(const float* x, const float* h, int taps) {
+    float acc[8] = { 0 };
+    for (int i = 0; i < taps; i += 8) {
+        for (int l = 0; l < 8; l++) {
+            float product = x[i + l] * h[i + l];
+            acc[l] += product;
+        }
+    }
+    float lanes[4];
+    for (int l = 0; l < 4; l++) lanes[l] = acc[l] + acc[l + 4];
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// acc0 holds lanes 0..3 and acc1 lanes 4..7
+__attribute__((target("sse2")))
+static float dot_sse2(const float* x, const float* h, int taps) {
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    for (int i = 0; i < taps; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(h + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(h + i + 4)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+// mul + add rather than FMA, which would round differently from the other kernels
+__attribute__((target("avx2")))
+static float dot_avx2(const float* x, const float* h, int taps) {
+    __m256 acc = _mm256_setzero_ps();
+    for (int i = 0; i < taps; i += 8) {
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(h + i)));
+    }
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+#endif
+
+typedef float (*DotFn)(const float*, const float*, int);
+
+static DotFn dot_kernel = dot_scalar;
+static pthread_once_t dot_kernel_once = PTHREAD_ONCE_INIT;
+
+static void select_dot_kernel(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        dot_kernel = dot_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        dot_kernel = dot_sse2;
+    }
+#endif
+}
+
+DecimatedAudio* decimate_pcm(const short* pcm, size_t pcm_size, int channels, int sample_rate, int factor) {
+    if (factor < 1 || (factor & (factor - 1)) || channels < 1) return NULL;
+    pthread_once(&dot_kernel_once, select_dot_kernel);
+
+    int taps = TAPS_PER_PHASE * factor;
+    size_t frames = pcm_size / channels;
+    DecimatedAudio* out = (DecimatedAudio*)malloc(sizeof(DecimatedAudio));
+    float* h = design_lowpass(factor, taps);
+    // Mono input with taps - 1 zeros in front, so the first outputs need no special case.
+    // Downmixed one block at a time, each block is used before the next is converted.
+    float* history = (float*)calloc(taps - 1 + DOWNMIX_BLOCK, sizeof(float));
+    float coef[DOWNMIX_BLOCK];
+    if (!out || !h || !history) {
+        printf("Erro ao alocar memoria para a decimacao.\n");
+        free(out);
+        free(h);
+        free(history);
+        return NULL;
+    }
+    out->size = (frames + factor - 1) / factor;
+    out->samples = (float*)malloc((out->size + 1) * sizeof(float));
+    out->source_rate = sample_rate;
+    out->factor = factor;
+    if (!out->samples) {
+        printf("Erro ao alocar memoria para a decimacao.\n");
+        free(out);
+        free(h);
+        free(history);
+        return NULL;
+    }
+
+    // Same downmix and int16 scale as the full-rate analyzer (rectangular window)
+    window_build(coef, DOWNMIX_BLOCK, WINDOW_RECTANGULAR, channels);
+
+    size_t next_output = 0;   // input frame index of the next kept sample
+    size_t produced = 0;
+    for (size_t start = 0; start < frames; start += DOWNMIX_BLOCK) {
+        int block = frames - start < DOWNMIX_BLOCK ? (int)(frames - start) : DOWNMIX_BLOCK;
+        float* mono = history + taps - 1;
+        window_apply(pcm + start * channels, channels, coef, mono, block);
+
+        // Output n is the filter over input frames n - taps + 1 .. n
+        while (next_output < start + block) {
+            out->samples[produced++] = dot_kernel(mono + (next_output - start) - (taps - 1), h, taps);
+            next_output += factor;
+        }
+        memmove(history, history + block, (taps - 1) * sizeof(float));
+    }
+    out->size = produced;
+
+    free(h);
+    free(history);
+    return out;
+}
+
+void free_decimated_audio(DecimatedAudio* audio) {
+    if (audio) {
+        free(audio->samples);
+        free(audio);
+    }
+}
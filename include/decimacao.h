@@ -0,0 +1,25 @@
+#ifndef DECIMACAO_H
+#define DECIMACAO_H
+
+#include <stddef.h>
+
+// Low-band copy of a song for the analyzer: every note in FREQS is below 1 kHz, so a
+// mono signal at ~5 kHz keeps all of them with 1/8 of the FFT work and PCM memory
+typedef struct {
+    float* samples;     // mono, low-passed, in [-1, 1) like the analyzer's FFT input
+    size_t size;
+    int source_rate;    // sample rate of the decoded MP3
+    int factor;         // samples[i] is at time i * factor / source_rate
+} DecimatedAudio;
+
+// Largest power-of-two factor (up to 16) that keeps the output rate at 4 kHz or more
+int decimation_factor_for_rate(int sample_rate);
+
+// Downmixes interleaved int16 PCM and decimates it by factor with a polyphase FIR
+// low-pass (only the kept outputs are computed). The FIR is vectorized with SSE2/AVX2
+// when the CPU has them; every path gives the same floats. Returns NULL on a bad factor or
+// if memory runs out.
+DecimatedAudio* decimate_pcm(const short* pcm, size_t pcm_size, int channels, int sample_rate, int factor);
+void free_decimated_audio(DecimatedAudio* audio);
+
+#endif // DECIMACAO_H
@@ -0,0 +1,95 @@
+// minimp3 again, built with float output. Its public functions are renamed so this
+// translation unit links next to the int16 build in mapeamento_audio.c.
+#define MINIMP3_IMPLEMENTATION
+#define MINIMP3_FLOAT_OUTPUT
+#define mp3dec_init mp3dec_init_f32
+#define mp3dec_decode_frame mp3dec_decode_frame_f32
+#define mp3dec_f32_to_s16 mp3dec_f32_to_s16_f32
+#include "minimp3.h"
+#include "decodificacao_float.h"
+#include "mapeamento_audio.h"
+#include <string.h>
+
+DecimatedAudio* load_mp3_mono_float(const char* filename) {
+    FILE* f = fopen(filename, "rb");
+    if (!f) {
+        printf("Erro ao abrir o arquivo '%s'!\n", filename);
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    unsigned char* mp3_buffer = (unsigned char*)malloc(file_size);
+    if (!mp3_buffer) {
+        printf("Erro ao alocar memoria para o buffer do MP3.\n");
+        fclose(f);
+        return NULL;
+    }
+    if (fread(mp3_buffer, 1, file_size, f) != (size_t)file_size) {
+        printf("Erro ao ler o arquivo MP3 para o buffer.\n");
+        free(mp3_buffer);
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+
+    // The estimate counts interleaved samples; mono needs at most that many
+    size_t capacity = estimate_pcm_samples(mp3_buffer, file_size) + MINIMP3_MAX_SAMPLES_PER_FRAME;
+    DecimatedAudio* audio = (DecimatedAudio*)malloc(sizeof(DecimatedAudio));
+    float* samples = (float*)malloc(capacity * sizeof(float));
+    if (!audio || !samples) {
+        printf("Erro ao alocar memoria para o audio em float.\n");
+        free(audio);
+        free(samples);
+        free(mp3_buffer);
+        return NULL;
+    }
+
+    mp3dec_t dec;
+    mp3dec_init(&dec);
+    mp3dec_frame_info_t info = {0};
+    float frame[MINIMP3_MAX_SAMPLES_PER_FRAME];
+    const unsigned char* mp3_ptr = mp3_buffer;
+    long remaining = file_size;
+    size_t size = 0;
+    int sample_rate = 0;
+
+    for (;;) {
+        int decoded = mp3dec_decode_frame(&dec, mp3_ptr, remaining, frame, &info);
+        if (decoded <= 0) break;
+        mp3_ptr += info.frame_bytes;
+        remaining -= info.frame_bytes;
+        if (!sample_rate) sample_rate = info.hz;
+
+        if (capacity - size < (size_t)decoded) {
+            float* grown = (float*)realloc(samples, capacity * 2 * sizeof(float));
+            if (!grown) {
+                printf("Erro ao alocar memoria para o audio em float.\n");
+                free(samples);
+                free(audio);
+                free(mp3_buffer);
+                return NULL;
+            }
+            samples = grown;
+            capacity *= 2;
+        }
+
+        float* out = samples + size;
+        if (info.channels == 2) {
+            // Same downmix as the int16 path, (L + R) / 2
+            for (int i = 0; i < decoded; i++) out[i] = (frame[i*2] + frame[i*2 + 1]) * 0.5f;
+        } else {
+            memcpy(out, frame, decoded * sizeof(float));
+        }
+        size += decoded;
+    }
+    free(mp3_buffer);
+
+    audio->samples = samples;
+    audio->size = size;
+    audio->source_rate = sample_rate;
+    audio->factor = 1;
+    return audio;
+}
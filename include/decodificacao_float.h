@@ -0,0 +1,13 @@
+#ifndef DECODIFICACAO_FLOAT_H
+#define DECODIFICACAO_FLOAT_H
+
+#include "decimacao.h"
+
+// Decodes an MP3 straight to mono float for the analyzer, using minimp3's float output.
+// This skips the int16 round trip (quantize in the decoder, then convert back and divide by
+// 32768 in the analyzer) and the separate downmix pass over interleaved PCM, because each
+// decoded frame is downmixed while it is still in cache. The result is a DecimatedAudio with
+// factor 1, ready for analyze_decimated_to_file. Returns NULL on error.
+DecimatedAudio* load_mp3_mono_float(const char* filename);
+
+#endif // DECODIFICACAO_FLOAT_H
@@ -0,0 +1,111 @@
+#include "indice_mp3.h"
+#include "decodificacao_paralela.h"
+#include <string.h>
+#include <pthread.h>
+
+#define DECODE_MIN_CHUNK_FRAMES 256   // below this the warm-up is a noticeable share of a chunk
+
+// A contiguous range of frames decoded by one worker thread
+typedef struct {
+    const Mp3Source* source;
+    short* pcm;
+    long first_frame;
+    long end_frame;
+    long stop_frame;   // out: first frame the sequential decoder would stop at, or end_frame
+    int ok;            // out: 0 if the decoder's frames differed from the index
+    int spawned;       // runs on its own thread
+} DecodeRangeJob;
+
+static void* decode_frame_range(void* arg) {
+    DecodeRangeJob* job = (DecodeRangeJob*)arg;
+    short scratch[MINIMP3_MAX_SAMPLES_PER_FRAME];
+    const Mp3FrameEntry* frames = job->source->index->frames;
+    mp3dec_t dec;
+    job->stop_frame = job->end_frame;
+    job->ok = mp3_index_prime(job->source, &dec, job->first_frame, scratch) == 0;
+    if (!job->ok) return NULL;
+
+    for (long k = job->first_frame; k < job->end_frame; k++) {
+        // The range's last frame goes through scratch, so a frame that is not what the index
+        // says can never write into the next worker's slice
+        short* out = k + 1 < job->end_frame ? job->pcm + frames[k].pcm_offset : scratch;
+        int samples = mp3_index_decode_frame(job->source, &dec, k, out);
+        if (samples < 0) {
+            job->ok = 0;
+            return NULL;
+        }
+        if (samples == 0) {
+            job->stop_frame = k;
+            return NULL;
+        }
+        if (out == scratch) {
+            memcpy(job->pcm + frames[k].pcm_offset, scratch,
+                   (frames[k + 1].pcm_offset - frames[k].pcm_offset) * sizeof(short));
+        }
+    }
+    return NULL;
+}
+
+AudioData* load_mp3_file_parallel(const char* filename, int num_threads) {
+    Mp3Source source;
+    if (mp3_source_open(&source, filename) != 0) return NULL;
+    const Mp3FrameEntry* frames = source.index->frames;
+    long frame_count = source.index->frame_count;
+
+    AudioData* audio_data = (AudioData*)malloc(sizeof(AudioData));
+    short* pcm = (short*)malloc((frames[frame_count].pcm_offset + 1) * sizeof(short));
+    if (num_threads > frame_count / DECODE_MIN_CHUNK_FRAMES) num_threads = (int)(frame_count / DECODE_MIN_CHUNK_FRAMES);
+    if (num_threads < 1) num_threads = 1;
+    pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+    DecodeRangeJob* jobs = (DecodeRangeJob*)malloc(num_threads * sizeof(DecodeRangeJob));
+    if (!audio_data || !pcm || !threads || !jobs) {
+        printf("Erro ao alocar memoria para a decodificacao paralela.\n");
+        mp3_source_close(&source);
+        free(audio_data);
+        free(pcm);
+        free(threads);
+        free(jobs);
+        return NULL;
+    }
+
+    for (int t = 0; t < num_threads; t++) {
+        jobs[t].source = &source;
+        jobs[t].pcm = pcm;
+        jobs[t].first_frame = frame_count * t / num_threads;
+        jobs[t].end_frame = frame_count * (t + 1) / num_threads;
+        jobs[t].spawned = t > 0 && pthread_create(&threads[t], NULL, decode_frame_range, &jobs[t]) == 0;
+    }
+    // The calling thread takes the first range, and any range a thread could not be spawned for
+    for (int t = 0; t < num_threads; t++) {
+        if (!jobs[t].spawned) decode_frame_range(&jobs[t]);
+    }
+    for (int t = 0; t < num_threads; t++) {
+        if (jobs[t].spawned) pthread_join(threads[t], NULL);
+    }
+
+    // The sequential decoder stops at the first frame that yields no samples; whatever the
+    // ranges after it decoded is dropped
+    long stop = frame_count;
+    int ok = 1;
+    for (int t = 0; t < num_threads && stop == frame_count; t++) {
+        ok = ok && jobs[t].ok;
+        if (jobs[t].stop_frame < jobs[t].end_frame) stop = jobs[t].stop_frame;
+    }
+    free(threads);
+    free(jobs);
+    if (!ok) {
+        mp3_source_close(&source);
+        free(pcm);
+        free(audio_data);
+        return load_mp3_file(filename);
+    }
+
+    // load_mp3_file keeps the format of the last frame it looked at, including the one it stopped on
+    const Mp3FrameEntry* last = stop < frame_count ? &frames[stop] : frame_count > 0 ? &frames[frame_count - 1] : NULL;
+    audio_data->pcm_buffer = pcm;
+    audio_data->pcm_size = frames[stop].pcm_offset;
+    audio_data->sample_rate = last ? last->hz : 0;
+    audio_data->channels = last ? last->channels : 0;
+    mp3_source_close(&source);
+    return audio_data;
+}
@@ -0,0 +1,13 @@
+#ifndef DECODIFICACAO_PARALELA_H
+#define DECODIFICACAO_PARALELA_H
+
+#include "mapeamento_audio.h"
+
+// Same AudioData as load_mp3_file, sample for sample, with the decode split over num_threads.
+// The song's frame index (indice_mp3.h) gives each frame's PCM offset; each worker then decodes
+// a contiguous range of frames straight into its slice of the buffer, after decoding (and
+// discarding) a few frames before it to refill the bit reservoir and the IMDCT/filterbank
+// state. Falls back to load_mp3_file if a worker's frames ever disagree with the index.
+AudioData* load_mp3_file_parallel(const char* filename, int num_threads);
+
+#endif // DECODIFICACAO_PARALELA_H
@@ -0,0 +1,153 @@
+// kiss_fft again, built with USE_SIMD (kiss_fft_scalar is an __m128). Its public functions are
+// renamed so this translation unit links next to the float build in kiss_fft.c/kiss_fftr.c.
+#include "fft_lotes.h"
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#ifdef __i386__
+#pragma GCC target("sse2")   // only reached after the CPU check in fft_batch_alloc
+#endif
+#define USE_SIMD
+#define kiss_fft_alloc kiss_fft_alloc_simd
+#define kiss_fft kiss_fft_simd
+#define kiss_fft_stride kiss_fft_stride_simd
+#define kiss_fft_cleanup kiss_fft_cleanup_simd
+#define kiss_fft_next_fast_size kiss_fft_next_fast_size_simd
+#define kiss_fftr_alloc kiss_fftr_alloc_simd
+#define kiss_fftr kiss_fftr_simd
+#define kiss_fftri kiss_fftri_simd
+#include "kiss_fft.c"
+#include "kiss_fftr.c"
+#include <emmintrin.h>
+
+struct FftBatch {
+    kiss_fftr_cfg cfg;
+    int nfft;
+    kiss_fft_scalar* in;    // nfft samples, lane l = frame l
+    kiss_fft_cpx* out;      // nfft / 2 + 1 bins
+    float* lanes;           // FFT_BATCH_LANES frames of nfft floats, filled by the caller
+    size_t bytes;
+};
+
+#define ALIGN16(n) (((n) + 15) & ~(size_t)15)
+
+FftBatch* fft_batch_alloc(int nfft) {
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("sse2") || nfft <= 0 || (nfft & 3)) return NULL;
+
+    size_t cfg_bytes = 0;
+    kiss_fftr_alloc(nfft, 0, NULL, &cfg_bytes);   // only reports the size
+    size_t header = ALIGN16(sizeof(FftBatch));
+    size_t in_bytes = (size_t)nfft * sizeof(kiss_fft_scalar);
+    size_t out_bytes = ((size_t)nfft / 2 + 1) * sizeof(kiss_fft_cpx);
+    size_t lane_bytes = (size_t)FFT_BATCH_LANES * nfft * sizeof(float);
+    size_t bytes = header + in_bytes + out_bytes + lane_bytes + ALIGN16(cfg_bytes);
+
+    // One block for everything, so a plan that keeps a batch counts a single allocation
+    char* block = (char*)_mm_malloc(bytes, 16);
+    if (!block) return NULL;
+    FftBatch* batch = (FftBatch*)block;
+    batch->nfft = nfft;
+    batch->bytes = bytes;
+    batch->in = (kiss_fft_scalar*)(block + header);
+    batch->out = (kiss_fft_cpx*)(block + header + in_bytes);
+    batch->lanes = (float*)(block + header + in_bytes + out_bytes);
+    batch->cfg = kiss_fftr_alloc(nfft, 0, block + header + in_bytes + out_bytes + lane_bytes, &cfg_bytes);
+    if (!batch->cfg) {
+        _mm_free(block);
+        return NULL;
+    }
+    return batch;
+}
+
+void fft_batch_free(FftBatch* batch) {
+    if (batch) _mm_free(batch);
+}
+
+size_t fft_batch_bytes(const FftBatch* batch) {
+    return batch ? batch->bytes : 0;
+}
+
+float* fft_batch_lane(FftBatch* batch, int lane) {
+    return batch->lanes + (size_t)lane * batch->nfft;
+}
+
+void fft_batch_peaks(FftBatch* batch, int lanes, int first, int end, int* peak, float* peak_sq) {
+    int nfft = batch->nfft;
+    const float* l0 = batch->lanes;
+    const float* l1 = l0 + nfft;
+    const float* l2 = l1 + nfft;
+    const float* l3 = l2 + nfft;
+
+    // Transpose 4 samples of each frame at a time; missing lanes repeat frame 0 and are dropped
+    if (lanes < 2) l1 = l0;
+    if (lanes < 3) l2 = l0;
+    if (lanes < 4) l3 = l0;
+    for (int i = 0; i < nfft; i += 4) {
+        __m128 a = _mm_loadu_ps(l0 + i);
+        __m128 b = _mm_loadu_ps(l1 + i);
+        __m128 c = _mm_loadu_ps(l2 + i);
+        __m128 d = _mm_loadu_ps(l3 + i);
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        batch->in[i] = a;
+        batch->in[i + 1] = b;
+        batch->in[i + 2] = c;
+        batch->in[i + 3] = d;
+    }
+    kiss_fftr(batch->cfg, batch->in, batch->out);
+
+    // spectrum_peak lane by lane: strictly larger wins, so ties keep the lowest bin
+    __m128 vmax = _mm_setzero_ps();
+    __m128i vidx = _mm_set1_epi32(first);
+    for (int i = first; i < end; i++) {
+        __m128 sq = _mm_add_ps(_mm_mul_ps(batch->out[i].r, batch->out[i].r),
+                               _mm_mul_ps(batch->out[i].i, batch->out[i].i));
+        __m128 gt = _mm_cmpgt_ps(sq, vmax);
+        vmax = _mm_or_ps(_mm_and_ps(gt, sq), _mm_andnot_ps(gt, vmax));
+        __m128i gti = _mm_castps_si128(gt);
+        vidx = _mm_or_si128(_mm_and_si128(gti, _mm_set1_epi32(i)), _mm_andnot_si128(gti, vidx));
+    }
+
+    float lane_max[4];
+    int32_t lane_idx[4];
+    _mm_storeu_ps(lane_max, vmax);
+    _mm_storeu_si128((__m128i*)lane_idx, vidx);
+    for (int l = 0; l < lanes; l++) {
+        peak[l] = lane_idx[l];
+        peak_sq[l] = lane_max[l];
+    }
+}
+
+#else
+
+FftBatch* fft_batch_alloc(int nfft) {
+    (void)nfft;
+    return NULL;
+}
+
+void fft_batch_free(FftBatch* batch) {
+    (void)batch;
+}
+
+size_t fft_batch_bytes(const FftBatch* batch) {
+    (void)batch;
+    return 0;
+}
+
+float* fft_batch_lane(FftBatch* batch, int lane) {
+    (void)batch;
+    (void)lane;
+    return NULL;
+}
+
+void fft_batch_peaks(FftBatch* batch, int lanes, int first, int end, int* peak, float* peak_sq) {
+    (void)batch;
+    (void)lanes;
+    (void)first;
+    (void)end;
+    (void)peak;
+    (void)peak_sq;
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef FFT_LOTES_H
+#define FFT_LOTES_H
+
+#include <stddef.h>
+
+#define FFT_BATCH_LANES 4   // frames per transform, one per float of an __m128
+
+// Real FFTs of FFT_BATCH_LANES frames at once with kiss_fft's USE_SIMD build, in which every
+// scalar is an __m128 and lane l runs frame l's transform in lockstep with the others. One
+// plan serves the whole batch, so the butterflies and twiddle loads are shared four ways.
+// Each lane gets the same floats as kiss_fftr on that frame alone, and the same peak as
+// spectrum_peak, so the charts do not change. A batch is used by one thread at a time.
+typedef struct FftBatch FftBatch;
+
+// NULL when the CPU has no SSE2 (or is not x86) or memory runs out: use kiss_fftr per frame
+FftBatch* fft_batch_alloc(int nfft);
+void fft_batch_free(FftBatch* batch);
+size_t fft_batch_bytes(const FftBatch* batch);   // the single block fft_batch_alloc made
+
+// nfft floats for lane's frame, to be filled (windowed) before fft_batch_peaks
+float* fft_batch_lane(FftBatch* batch, int lane);
+
+// Transforms lanes 0..lanes-1 and finds each one's peak bin in [first, end) like
+// spectrum_peak: peak[l] gets the bin, peak_sq[l] its squared magnitude
+void fft_batch_peaks(FftBatch* batch, int lanes, int first, int end, int* peak, float* peak_sq);
+
+#endif // FFT_LOTES_H
@@ -0,0 +1,67 @@
+#include "fila_pistas.h"
+#include <stdlib.h>
+
+void lane_queues_clear(LaneQueues* queues) {
+    for (int l = 0; l < LANE_COUNT; l++) {
+        queues->lanes[l].size = 0;
+        queues->lanes[l].cursor = 0;
+    }
+}
+
+void lane_queues_free(LaneQueues* queues) {
+    for (int l = 0; l < LANE_COUNT; l++) {
+        free(queues->lanes[l].timestamps);
+        free(queues->lanes[l].notes);
+        queues->lanes[l].timestamps = NULL;
+        queues->lanes[l].notes = NULL;
+        queues->lanes[l].size = 0;
+        queues->lanes[l].capacity = 0;
+        queues->lanes[l].cursor = 0;
+    }
+}
+
+static int lane_reserve(LaneQueue* lane, int needed) {
+    if (lane->capacity >= needed) return 0;
+    int capacity = lane->capacity > 0 ? lane->capacity * 2 : 256;
+    if (capacity < needed) capacity = needed;
+    float* timestamps = (float*)realloc(lane->timestamps, capacity * sizeof(float));
+    if (!timestamps) return -1;
+    lane->timestamps = timestamps;
+    int* notes = (int*)realloc(lane->notes, capacity * sizeof(int));
+    if (!notes) return -1;
+    lane->notes = notes;
+    lane->capacity = capacity;
+    return 0;
+}
+
+int lane_queues_push(LaneQueues* queues, int lane, float timestamp, int note) {
+    if (lane < 0 || lane >= LANE_COUNT) return -1;
+    LaneQueue* q = &queues->lanes[lane];
+    if (lane_reserve(q, q->size + 1) != 0) return -1;
+
+    // Insertion step: a sorted chart never enters the loop
+    int i = q->size;
+    while (i > q->cursor && q->timestamps[i - 1] > timestamp) {
+        q->timestamps[i] = q->timestamps[i - 1];
+        q->notes[i] = q->notes[i - 1];
+        i--;
+    }
+    q->timestamps[i] = timestamp;
+    q->notes[i] = note;
+    q->size++;
+    return 0;
+}
+
+int lane_queues_hit(LaneQueues* queues, int lane, double t, double window) {
+    if (lane < 0 || lane >= LANE_COUNT) return -1;
+    LaneQueue* q = &queues->lanes[lane];
+
+    // Windows that closed before t stay closed
+    while (q->cursor < q->size && t >= q->timestamps[q->cursor] + window) q->cursor++;
+
+    // Later notes open their window no earlier than this one
+    if (q->cursor < q->size && t > q->timestamps[q->cursor] - window) {
+        return q->notes[q->cursor++];
+    }
+    return -1;
+}
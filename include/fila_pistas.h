@@ -0,0 +1,35 @@
+#ifndef FILA_PISTAS_H
+#define FILA_PISTAS_H
+
+#define LANE_COUNT 4
+
+// Notes of one lane in time order, for hit judgment. Everything before cursor has been
+// judged (hit, or its window is over), so a press only ever looks at the note at cursor.
+typedef struct {
+    float* timestamps;
+    int* notes;          // index of each note in the game's note array
+    int size;
+    int capacity;
+    int cursor;
+} LaneQueue;
+
+typedef struct {
+    LaneQueue lanes[LANE_COUNT];
+} LaneQueues;
+
+// A zeroed LaneQueues is empty and valid; clear keeps the memory for the next song
+void lane_queues_clear(LaneQueues* queues);
+void lane_queues_free(LaneQueues* queues);
+
+// Adds note to lane (0..LANE_COUNT-1), keeping the lane in time order. Charts arrive sorted,
+// so this is O(1) for them; an out-of-order note is moved back to its place, and notes with
+// the same time keep the order they were pushed in. Returns -1 for a bad lane or no memory.
+int lane_queues_push(LaneQueues* queues, int lane, float timestamp, int note);
+
+// The note a press on lane at time t hits: the lane's earliest note with
+// timestamp - window < t < timestamp + window, which is consumed. Notes whose window has
+// already closed are dropped on the way; t must not go back between calls. Amortized O(1)
+// per press, whatever the chart length. Returns -1 when no note is in reach.
+int lane_queues_hit(LaneQueues* queues, int lane, double t, double window);
+
+#endif // FILA_PISTAS_H
@@ -0,0 +1,291 @@
+#include "indice_mp3.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define DECODE_WARMUP_FRAMES 4   // doubled until one of them restores the bit reservoir
+
+Mp3Index* mp3_index_build(const unsigned char* mp3, long mp3_size) {
+    Mp3Index* index = (Mp3Index*)malloc(sizeof(Mp3Index));
+    long capacity = mp3_size / 256 + 64;
+    Mp3FrameEntry* frames = (Mp3FrameEntry*)malloc(capacity * sizeof(Mp3FrameEntry));
+    if (!index || !frames) {
+        free(index);
+        free(frames);
+        return NULL;
+    }
+
+    mp3dec_t dec;
+    mp3dec_init(&dec);
+    mp3dec_frame_info_t info;
+    long pos = 0, count = 0;
+    int64_t pcm = 0;
+    for (;;) {
+        if (count + 1 >= capacity) {
+            Mp3FrameEntry* grown = (Mp3FrameEntry*)realloc(frames, capacity * 2 * sizeof(Mp3FrameEntry));
+            if (!grown) {
+                free(frames);
+                free(index);
+                return NULL;
+            }
+            frames = grown;
+            capacity *= 2;
+        }
+        frames[count].mp3_offset = pos;
+        frames[count].pcm_offset = pcm;
+        frames[count].hz = 0;
+        frames[count].channels = 0;
+        int samples = mp3dec_decode_frame(&dec, mp3 + pos, mp3_size - pos, NULL, &info);
+        if (samples <= 0) break;
+        frames[count].hz = info.hz;
+        frames[count].channels = info.channels;
+        pcm += samples * info.channels;
+        pos += info.frame_bytes;
+        count++;
+    }
+    index->frames = frames;
+    index->frame_count = count;
+    return index;
+}
+
+void mp3_index_free(Mp3Index* index) {
+    if (index) {
+        free(index->frames);
+        free(index);
+    }
+}
+
+static char* index_path(const char* mp3_filename) {
+    size_t len = strlen(mp3_filename);
+    char* path = (char*)malloc(len + sizeof(MP3_INDEX_EXTENSION));
+    if (!path) return NULL;
+    memcpy(path, mp3_filename, len);
+    strcpy(path + len, MP3_INDEX_EXTENSION);
+    return path;
+}
+
+int mp3_index_save(const Mp3Index* index, const char* mp3_filename) {
+    struct stat st;
+    if (stat(mp3_filename, &st) != 0) return -1;
+
+    Mp3IndexHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MP3_INDEX_MAGIC;
+    header.version = MP3_INDEX_VERSION;
+    header.header_size = sizeof(Mp3IndexHeader);
+    header.frame_count = (uint32_t)index->frame_count;
+    header.mp3_size = st.st_size;
+    header.mp3_mtime = st.st_mtime;
+
+    char* path = index_path(mp3_filename);
+    FILE* f = path ? fopen(path, "wb") : NULL;
+    free(path);
+    if (!f) return -1;
+    size_t entries = index->frame_count + 1;
+    int ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+             fwrite(index->frames, sizeof(Mp3FrameEntry), entries, f) == entries;
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+// The saved index, if it was made from this very file: same size and modification time,
+// and a file size that matches its frame count (a write cut short is rejected too)
+static Mp3Index* index_load(const char* mp3_filename, long mp3_size) {
+    struct stat st;
+    if (stat(mp3_filename, &st) != 0) return NULL;
+    char* path = index_path(mp3_filename);
+    FILE* f = path ? fopen(path, "rb") : NULL;
+    free(path);
+    if (!f) return NULL;
+
+    Mp3IndexHeader header;
+    Mp3Index* index = NULL;
+    if (fread(&header, sizeof(header), 1, f) == 1 &&
+        header.magic == MP3_INDEX_MAGIC && header.version == MP3_INDEX_VERSION &&
+        header.header_size == sizeof(Mp3IndexHeader) &&
+        header.mp3_size == mp3_size && header.mp3_size == st.st_size && header.mp3_mtime == st.st_mtime &&
+        header.frame_count <= (uint64_t)mp3_size) {
+        size_t entries = (size_t)header.frame_count + 1;
+        index = (Mp3Index*)malloc(sizeof(Mp3Index));
+        Mp3FrameEntry* frames = (Mp3FrameEntry*)malloc(entries * sizeof(Mp3FrameEntry));
+        if (index && frames && fread(frames, sizeof(Mp3FrameEntry), entries, f) == entries &&
+            fgetc(f) == EOF && frames[header.frame_count].mp3_offset <= mp3_size) {
+            index->frames = frames;
+            index->frame_count = header.frame_count;
+        } else {
+            free(index);
+            free(frames);
+            index = NULL;
+        }
+    }
+    fclose(f);
+    return index;
+}
+
+Mp3Index* mp3_index_open(const char* mp3_filename, const unsigned char* mp3, long mp3_size) {
+    Mp3Index* index = index_load(mp3_filename, mp3_size);
+    if (index) return index;
+    index = mp3_index_build(mp3, mp3_size);
+    // Without write access to the song's folder the index is just rebuilt next time
+    if (index) mp3_index_save(index, mp3_filename);
+    return index;
+}
+
+int mp3_source_open(Mp3Source* source, const char* mp3_filename) {
+    memset(source, 0, sizeof(*source));
+    int fd = open(mp3_filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Erro ao abrir o arquivo '%s'!\n", mp3_filename);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        printf("Erro ao ler o arquivo '%s'!\n", mp3_filename);
+        close(fd);
+        return -1;
+    }
+    if (st.st_size > 0) {
+        void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            printf("Erro ao mapear o arquivo '%s' na memoria!\n", mp3_filename);
+            close(fd);
+            return -1;
+        }
+        source->mp3 = (const unsigned char*)data;
+    }
+    close(fd);
+    source->mp3_size = (long)st.st_size;
+
+    source->index = mp3_index_open(mp3_filename, source->mp3, source->mp3_size);
+    if (!source->index) {
+        printf("Erro ao alocar memoria para o indice de frames.\n");
+        mp3_source_close(source);
+        return -1;
+    }
+    return 0;
+}
+
+void mp3_source_close(Mp3Source* source) {
+    if (source->mp3) munmap((void*)source->mp3, source->mp3_size);
+    mp3_index_free(source->index);
+    memset(source, 0, sizeof(*source));
+}
+
+long mp3_index_frame_at_sample(const Mp3Index* index, int64_t pcm_offset) {
+    const Mp3FrameEntry* frames = index->frames;
+    long count = index->frame_count;
+    if (count == 0 || pcm_offset <= 0) return 0;
+    if (pcm_offset >= frames[count].pcm_offset) return count;
+
+    // Every Layer III frame at one rate has the same length, so the guess is usually the frame
+    int64_t frame_pcm = frames[1].pcm_offset - frames[0].pcm_offset;
+    long k = (long)(pcm_offset / frame_pcm);
+    if (k < count && frames[k].pcm_offset <= pcm_offset && pcm_offset < frames[k + 1].pcm_offset) return k;
+
+    long lo = 0, hi = count;   // frames[lo].pcm_offset <= pcm_offset < frames[hi].pcm_offset
+    while (hi - lo > 1) {
+        long mid = lo + (hi - lo) / 2;
+        if (frames[mid].pcm_offset <= pcm_offset) lo = mid;
+        else hi = mid;
+    }
+    return lo;
+}
+
+long mp3_index_frame_at(const Mp3Index* index, double seconds) {
+    if (index->frame_count == 0 || seconds <= 0) return 0;
+    const Mp3FrameEntry* first = index->frames;
+    return mp3_index_frame_at_sample(index, (int64_t)(seconds * first->hz) * first->channels);
+}
+
+int mp3_index_decode_frame(const Mp3Source* source, mp3dec_t* dec, long k, short* out) {
+    const Mp3FrameEntry* frame = source->index->frames + k;
+    mp3dec_frame_info_t info;
+    int samples = mp3dec_decode_frame(dec, source->mp3 + frame->mp3_offset, source->mp3_size - frame->mp3_offset,
+                                      out, &info);
+    if (info.frame_bytes != frame[1].mp3_offset - frame->mp3_offset) return -1;
+    if (samples > 0 && (int64_t)samples * info.channels != frame[1].pcm_offset - frame->pcm_offset) return -1;
+    return samples > 0 ? samples : 0;
+}
+
+int mp3_index_prime(const Mp3Source* source, mp3dec_t* dec, long k, short* scratch) {
+    // A frame that decodes restores the reservoir with the same bytes as the sequential
+    // decoder, and the IMDCT overlap and filterbank history only depend on the latest
+    // granule, so everything after it matches. A fresh decoder syncs more strictly than one
+    // that follows the previous header (it wants several frames that match ahead), so near
+    // damaged data its first frame can differ from the index: that also means starting
+    // earlier. Frame 0 is where the sequential decoder starts.
+    long warmup = DECODE_WARMUP_FRAMES;
+    for (;;) {
+        long start = k > warmup ? k - warmup : 0;
+        int primed = start == 0;
+        mp3dec_init(dec);
+        for (long j = start; j < k; j++) {
+            int samples = mp3_index_decode_frame(source, dec, j, scratch);
+            if (samples < 0) {
+                if (start == 0) return -1;
+                primed = 0;
+                break;
+            }
+            if (samples > 0) primed = 1;
+        }
+        if (primed) return 0;
+        warmup *= 2;
+    }
+}
+
+AudioData* load_mp3_range(const char* filename, double start_seconds, double end_seconds,
+                          long tail_samples, size_t* first_pcm) {
+    Mp3Source source;
+    if (mp3_source_open(&source, filename) != 0) return NULL;
+    const Mp3Index* index = source.index;
+    const Mp3FrameEntry* frames = index->frames;
+
+    long first = mp3_index_frame_at(index, start_seconds);
+    long end = index->frame_count;
+    if (end_seconds > 0 && index->frame_count > 0) {
+        int64_t end_pcm = ((int64_t)(end_seconds * frames[0].hz) + tail_samples) * frames[0].channels;
+        end = mp3_index_frame_at_sample(index, end_pcm - 1) + 1;
+        if (end > index->frame_count) end = index->frame_count;
+    }
+    if (first > end) first = end;
+
+    AudioData* audio_data = (AudioData*)malloc(sizeof(AudioData));
+    // Room for one frame more than the index says, in case the file does not match it
+    size_t capacity = frames[end].pcm_offset - frames[first].pcm_offset + MINIMP3_MAX_SAMPLES_PER_FRAME;
+    short* pcm = (short*)malloc(capacity * sizeof(short));
+    short scratch[MINIMP3_MAX_SAMPLES_PER_FRAME];
+    if (!audio_data || !pcm) {
+        printf("Erro ao alocar memoria para o buffer PCM.\n");
+        free(audio_data);
+        free(pcm);
+        mp3_source_close(&source);
+        return NULL;
+    }
+
+    mp3dec_t dec;
+    long k = first;
+    int ok = mp3_index_prime(&source, &dec, first, scratch) == 0;
+    for (; ok && k < end; k++) {
+        int samples = mp3_index_decode_frame(&source, &dec, k, pcm + (frames[k].pcm_offset - frames[first].pcm_offset));
+        if (samples < 0) ok = 0;
+        if (samples <= 0) break;   // where the sequential decoder stops
+    }
+    if (!ok) {
+        printf("Indice de frames de '%s' nao confere com o arquivo.\n", filename);
+        free(audio_data);
+        free(pcm);
+        mp3_source_close(&source);
+        return NULL;
+    }
+
+    // Format of the range's first frame; a song has a single one in practice
+    audio_data->pcm_buffer = pcm;
+    audio_data->pcm_size = frames[k].pcm_offset - frames[first].pcm_offset;
+    audio_data->sample_rate = first < index->frame_count ? frames[first].hz : 0;
+    audio_data->channels = first < index->frame_count ? frames[first].channels : 0;
+    *first_pcm = frames[first].pcm_offset;
+    mp3_source_close(&source);
+    return audio_data;
+}
@@ -0,0 +1,79 @@
+#ifndef INDICE_MP3_H
+#define INDICE_MP3_H
+
+#include <stdint.h>
+#include "minimp3.h"
+#include "mapeamento_audio.h"
+
+// Frame index of an MP3 (<song>.idx, saved next to it): where each frame starts in the file
+// and in the decoded PCM, so a time maps to a frame without walking the stream. It is built
+// with a header-only pass the first time and reused while the song keeps its size and
+// modification time. Fields are little-endian, like the compiled chart.
+#define MP3_INDEX_MAGIC 0x58494847u   // "GHIX"
+#define MP3_INDEX_VERSION 1
+#define MP3_INDEX_EXTENSION ".idx"
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t frame_count;
+    uint32_t reserved;
+    int64_t mp3_size;
+    int64_t mp3_mtime;
+} Mp3IndexHeader;   // followed by frame_count + 1 Mp3FrameEntry
+
+// Where mp3dec_decode_frame is called for a frame (any junk it skips included) and the first
+// interleaved sample it writes; entry i + 1 bounds frame i
+typedef struct {
+    int64_t mp3_offset;
+    int64_t pcm_offset;
+    int32_t hz;
+    int32_t channels;
+} Mp3FrameEntry;
+
+typedef struct {
+    Mp3FrameEntry* frames;   // frame_count + 1 entries, the last one only bounds the stream
+    long frame_count;
+} Mp3Index;
+
+// A song mmapped together with its index
+typedef struct {
+    const unsigned char* mp3;
+    long mp3_size;
+    Mp3Index* index;
+} Mp3Source;
+
+// Same frame walk as the sequential decode; minimp3 with a NULL output only parses headers
+Mp3Index* mp3_index_build(const unsigned char* mp3, long mp3_size);
+void mp3_index_free(Mp3Index* index);
+// Loads <mp3_filename>.idx if it still matches the song, else builds the index and tries to save it
+Mp3Index* mp3_index_open(const char* mp3_filename, const unsigned char* mp3, long mp3_size);
+int mp3_index_save(const Mp3Index* index, const char* mp3_filename);
+
+int mp3_source_open(Mp3Source* source, const char* mp3_filename);
+void mp3_source_close(Mp3Source* source);
+
+// Frame holding the interleaved sample at seconds (in the first frame's format), frame_count
+// past the end. A guess from the frame length, checked against the index: O(1) for constant
+// frame lengths, a binary search otherwise.
+long mp3_index_frame_at(const Mp3Index* index, double seconds);
+long mp3_index_frame_at_sample(const Mp3Index* index, int64_t pcm_offset);
+
+// Decodes frame k into out and checks it against the index; returns the samples, 0 for a
+// frame the sequential decoder would stop at, -1 if the index does not hold
+int mp3_index_decode_frame(const Mp3Source* source, mp3dec_t* dec, long k, short* out);
+// Leaves dec as the sequential decoder has it before frame k, by decoding (and discarding)
+// a few frames before it; scratch holds MINIMP3_MAX_SAMPLES_PER_FRAME samples. -1 if the
+// index does not hold.
+int mp3_index_prime(const Mp3Source* source, mp3dec_t* dec, long k, short* scratch);
+
+// The frames that cover [start_seconds, end_seconds) plus tail_samples per channel past the
+// end (end_seconds <= 0: to the end of the song), sample for sample what load_mp3_file has
+// there. *first_pcm gets the song's interleaved offset of pcm_buffer[0]. load_mp3_file gives
+// up at a frame whose bit reservoir cannot be refilled (a cut in the middle of the file);
+// only frames decoded from the start see that, so a range after such a cut is still decoded.
+AudioData* load_mp3_range(const char* filename, double start_seconds, double end_seconds,
+                          long tail_samples, size_t* first_pcm);
+
+#endif // INDICE_MP3_H
@@ -0,0 +1,124 @@
+#include "janela.h"
+#include <math.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+void window_build(float* coef, int size, WindowType type, int channels) {
+    double sum = 0;
+    for (int i = 0; i < size; i++) {
+        // Periodic windows: overlapping frames at size/2 or size/4 hops add up evenly
+        double phase = 2.0 * M_PI * i / size;
+        double w = 1.0;
+        if (type == WINDOW_HANN) {
+            w = 0.5 - 0.5 * cos(phase);
+        } else if (type == WINDOW_BLACKMAN) {
+            w = 0.42 - 0.5 * cos(phase) + 0.08 * cos(2.0 * phase);
+        }
+        coef[i] = (float)w;
+        sum += w;
+    }
+
+    // Rectangular: exactly 1/32768 (or 1/65536 for the L + R sum), same samples as before
+    double scale = (double)size / sum / (channels == 2 ? 65536.0 : 32768.0);
+    for (int i = 0; i < size; i++) {
+        coef[i] = (float)(coef[i] * scale);
+    }
+}
+
+static void window_apply_scalar(const short* frame, int channels, const float* coef, kiss_fft_scalar* out, int size) {
+    if (channels == 2) {
+        for (int i = 0; i < size; i++) {
+            out[i] = (float)(frame[i*2] + frame[i*2 + 1]) * coef[i];
+        }
+    } else {
+        for (int i = 0; i < size; i++) {
+            out[i] = (float)frame[i] * coef[i];
+        }
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("sse2")))
+static void window_apply_sse2(const short* frame, int channels, const float* coef, kiss_fft_scalar* out, int size) {
+    int count = size & ~7;
+    if (channels == 2) {
+        const __m128i ones = _mm_set1_epi16(1);
+        for (int i = 0; i < count; i += 4) {
+            // madd of L R pairs with 1 gives the exact int32 L + R, like the scalar sum
+            __m128i pcm = _mm_loadu_si128((const __m128i*)(frame + i * 2));
+            __m128 mono = _mm_cvtepi32_ps(_mm_madd_epi16(pcm, ones));
+            _mm_storeu_ps(out + i, _mm_mul_ps(mono, _mm_loadu_ps(coef + i)));
+        }
+    } else {
+        for (int i = 0; i < count; i += 8) {
+            __m128i pcm = _mm_loadu_si128((const __m128i*)(frame + i));
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(pcm, pcm), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(pcm, pcm), 16);
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), _mm_loadu_ps(coef + i)));
+            _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), _mm_loadu_ps(coef + i + 4)));
+        }
+    }
+    int step = channels == 2 ? 2 : 1;
+    window_apply_scalar(frame + count * step, channels, coef + count, out + count, size - count);
+}
+
+__attribute__((target("avx2")))
+static void window_apply_avx2(const short* frame, int channels, const float* coef, kiss_fft_scalar* out, int size) {
+    int count = size & ~7;
+    if (channels == 2) {
+        const __m256i ones = _mm256_set1_epi16(1);
+        for (int i = 0; i < count; i += 8) {
+            __m256i pcm = _mm256_loadu_si256((const __m256i*)(frame + i * 2));
+            __m256 mono = _mm256_cvtepi32_ps(_mm256_madd_epi16(pcm, ones));
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(mono, _mm256_loadu_ps(coef + i)));
+        }
+    } else {
+        for (int i = 0; i < count; i += 8) {
+            __m256i pcm = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(frame + i)));
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(pcm), _mm256_loadu_ps(coef + i)));
+        }
+    }
+    int step = channels == 2 ? 2 : 1;
+    window_apply_scalar(frame + count * step, channels, coef + count, out + count, size - count);
+}
+
+#endif
+
+typedef void (*WindowApplyFn)(const short*, int, const float*, kiss_fft_scalar*, int);
+
+static WindowApplyFn window_kernel = window_apply_scalar;
+static pthread_once_t window_kernel_once = PTHREAD_ONCE_INIT;
+
+static void select_window_kernel(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        window_kernel = window_apply_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        window_kernel = window_apply_sse2;
+    }
+#endif
+}
+
+void window_apply(const short* frame, int channels, const float* coef, kiss_fft_scalar* out, int size) {
+    pthread_once(&window_kernel_once, select_window_kernel);
+    window_kernel(frame, channels, coef, out, size);
+}
+
+int window_type_from_name(const char* name, WindowType* type) {
+    if (strcmp(name, "hann") == 0) {
+        *type = WINDOW_HANN;
+    } else if (strcmp(name, "blackman") == 0) {
+        *type = WINDOW_BLACKMAN;
+    } else if (strcmp(name, "rect") == 0) {
+        *type = WINDOW_RECTANGULAR;
+    } else {
+        return -1;
+    }
+    return 0;
+}
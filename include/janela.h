@@ -0,0 +1,25 @@
+#ifndef JANELA_H
+#define JANELA_H
+
+#include "kiss_fft.h"
+
+typedef enum {
+    WINDOW_RECTANGULAR,  // no taper, the original block analysis
+    WINDOW_HANN,
+    WINDOW_BLACKMAN
+} WindowType;
+
+// Fills coef[0..size) with the analysis window for interleaved PCM with the given channel
+// count. The int16 -> [-1, 1) scale and the stereo downmix are folded in, and tapered
+// windows are normalized to the rectangular window's gain so THRESHOLD keeps its meaning.
+void window_build(float* coef, int size, WindowType type, int channels);
+
+// out[i] = mono(frame[i]) * coef[i] for size samples. Stereo frames are summed as L + R,
+// any other channel count reads one sample per index. Vectorized with SSE2/AVX2 when the
+// CPU has them; every path gives the same floats.
+void window_apply(const short* frame, int channels, const float* coef, kiss_fft_scalar* out, int size);
+
+// Parses "hann", "blackman" or "rect"; returns -1 for anything else
+int window_type_from_name(const char* name, WindowType* type);
+
+#endif // JANELA_H
@@ -0,0 +1,230 @@
+#include "mapa_compilado.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Every note in the scale, on the lane its letter gives, in time order (NaN fails too)
+static int chart_notes_valid(const float* timestamps, const uint8_t* lanes, const uint8_t* notes, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (notes[i] >= CHART_NUM_NOTES || lanes[i] != chart_lane_for_note(notes[i])) return 0;
+        if (!(timestamps[i] == timestamps[i]) || (i > 0 && !(timestamps[i - 1] <= timestamps[i]))) return 0;
+    }
+    return 1;
+}
+
+int chart_write_compiled(const char* filename, const float* timestamps, const uint8_t* notes, uint32_t note_count) {
+    ChartHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CHART_MAGIC;
+    header.version = CHART_VERSION;
+    header.header_size = sizeof(ChartHeader);
+    header.note_count = note_count;
+    header.timestamps_offset = chart_align(sizeof(ChartHeader));
+    header.lanes_offset = chart_align(header.timestamps_offset + note_count * sizeof(float));
+    header.notes_offset = chart_align(header.lanes_offset + note_count);
+    header.file_size = header.notes_offset + note_count;
+
+    uint8_t* image = (uint8_t*)calloc(1, header.file_size);
+    if (!image) {
+        printf("Erro ao alocar memoria para o mapa compilado.\n");
+        return -1;
+    }
+    memcpy(image, &header, sizeof(header));
+    memcpy(image + header.timestamps_offset, timestamps, note_count * sizeof(float));
+    for (uint32_t i = 0; i < note_count; i++) {
+        image[header.lanes_offset + i] = chart_lane_for_note(notes[i]);
+    }
+    memcpy(image + header.notes_offset, notes, note_count);
+    // The same check chart_map_compiled makes: never write a chart the game would refuse
+    if (!chart_notes_valid((const float*)(image + header.timestamps_offset), image + header.lanes_offset,
+                           image + header.notes_offset, note_count)) {
+        printf("Erro: notas fora da escala ou fora de ordem no mapa '%s'.\n", filename);
+        free(image);
+        return -1;
+    }
+
+    FILE* f = fopen(filename, "wb");
+    if (!f) {
+        printf("Erro ao criar o arquivo '%s'!\n", filename);
+        free(image);
+        return -1;
+    }
+    size_t written = fwrite(image, 1, header.file_size, f);
+    fclose(f);
+    free(image);
+    if (written != header.file_size) {
+        printf("Erro ao escrever o arquivo '%s'!\n", filename);
+        return -1;
+    }
+    return 0;
+}
+
+int chart_sort_by_time(float* timestamps, uint8_t* values, uint32_t count) {
+    uint32_t first_unsorted = 1;
+    while (first_unsorted < count && !(timestamps[first_unsorted] < timestamps[first_unsorted - 1])) {
+        first_unsorted++;
+    }
+    if (first_unsorted >= count) return 0;
+
+    float* scratch_timestamps = (float*)malloc(count * sizeof(float));
+    uint8_t* scratch_values = (uint8_t*)malloc(count);
+    if (!scratch_timestamps || !scratch_values) {
+        free(scratch_timestamps);
+        free(scratch_values);
+        return -1;
+    }
+    // Bottom-up merge of runs of width notes, back and forth between the arrays and the
+    // scratch; on equal timestamps the left run goes first, which keeps file order
+    float* src_t = timestamps;
+    uint8_t* src_v = values;
+    float* dst_t = scratch_timestamps;
+    uint8_t* dst_v = scratch_values;
+    for (size_t width = 1; width < count; width *= 2) {
+        for (size_t lo = 0; lo < count; lo += 2 * width) {
+            size_t mid = lo + width < count ? lo + width : count;
+            size_t hi = lo + 2 * width < count ? lo + 2 * width : count;
+            size_t a = lo, b = mid, k = lo;
+            while (a < mid && b < hi) {
+                size_t from = src_t[b] < src_t[a] ? b++ : a++;
+                dst_t[k] = src_t[from];
+                dst_v[k++] = src_v[from];
+            }
+            for (; a < mid; a++, k++) {
+                dst_t[k] = src_t[a];
+                dst_v[k] = src_v[a];
+            }
+            for (; b < hi; b++, k++) {
+                dst_t[k] = src_t[b];
+                dst_v[k] = src_v[b];
+            }
+        }
+        float* t = src_t; src_t = dst_t; dst_t = t;
+        uint8_t* v = src_v; src_v = dst_v; dst_v = v;
+    }
+    if (src_t != timestamps) {
+        memcpy(timestamps, src_t, count * sizeof(float));
+        memcpy(values, src_v, count);
+    }
+    free(scratch_timestamps);
+    free(scratch_values);
+    return 0;
+}
+
+int chart_compile_text(const char* text_filename, const char* compiled_filename) {
+    FILE* f = fopen(text_filename, "r");
+    if (!f) {
+        printf("Erro ao abrir o arquivo '%s'!\n", text_filename);
+        return -1;
+    }
+
+    uint32_t count = 0, capacity = 1024;
+    float* timestamps = (float*)malloc(capacity * sizeof(float));
+    uint8_t* notes = (uint8_t*)malloc(capacity);
+    float timestamp;
+    char note_name[5];
+    int out_of_memory = !timestamps || !notes;
+
+    // Same tokens carregar_nivel reads; lines with a note outside the scale, or a NaN time
+    // the loader would refuse, are skipped
+    while (!out_of_memory && fscanf(f, "%f %4s", &timestamp, note_name) == 2) {
+        int note = chart_note_from_name(note_name);
+        if (note < 0 || note >= CHART_NUM_NOTES || !(timestamp == timestamp)) continue;
+        if (count == capacity) {
+            capacity *= 2;
+            float* t = (float*)realloc(timestamps, capacity * sizeof(float));
+            if (t) timestamps = t;
+            uint8_t* n = (uint8_t*)realloc(notes, capacity);
+            if (n) notes = n;
+            out_of_memory = !t || !n;
+            if (out_of_memory) break;
+        }
+        timestamps[count] = timestamp;
+        notes[count] = (uint8_t)note;
+        count++;
+    }
+    fclose(f);
+
+    // The analyzer already writes in time order; only hand-edited charts get sorted
+    if (out_of_memory || chart_sort_by_time(timestamps, notes, count) != 0) {
+        printf("Erro ao alocar memoria para o mapa compilado.\n");
+        free(timestamps);
+        free(notes);
+        return -1;
+    }
+
+    int result = chart_write_compiled(compiled_filename, timestamps, notes, count);
+    free(timestamps);
+    free(notes);
+    return result;
+}
+
+int chart_export_text(const char* compiled_filename, const char* text_filename) {
+    CompiledChart chart;
+    if (chart_map_compiled(compiled_filename, &chart) != 0) return -1;
+
+    FILE* f = fopen(text_filename, "w");
+    if (!f) {
+        printf("Erro ao criar o arquivo '%s'!\n", text_filename);
+        chart_unmap_compiled(&chart);
+        return -1;
+    }
+    char note_name[5];
+    for (uint32_t i = 0; i < chart.note_count; i++) {
+        chart_note_name(chart.notes[i], note_name);
+        fprintf(f, "%.2f\t%s\n", chart.timestamps[i], note_name);
+    }
+    fclose(f);
+    chart_unmap_compiled(&chart);
+    return 0;
+}
+
+static int chart_array_fits(uint32_t offset, uint32_t bytes, uint32_t file_size) {
+    return offset % CHART_ALIGN == 0 && offset <= file_size && bytes <= file_size - offset;
+}
+
+int chart_map_compiled(const char* filename, CompiledChart* chart) {
+    memset(chart, 0, sizeof(*chart));
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(ChartHeader)) {
+        close(fd);
+        return -1;
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return -1;
+
+    const ChartHeader* header = (const ChartHeader*)data;
+    uint32_t count = header->note_count;
+    if (header->magic != CHART_MAGIC || header->version != CHART_VERSION ||
+        header->header_size < sizeof(ChartHeader) || header->file_size != (uint64_t)st.st_size ||
+        count > header->file_size / (sizeof(float) + 2) ||
+        !chart_array_fits(header->timestamps_offset, count * sizeof(float), header->file_size) ||
+        !chart_array_fits(header->lanes_offset, count, header->file_size) ||
+        !chart_array_fits(header->notes_offset, count, header->file_size) ||
+        !chart_notes_valid((const float*)((const uint8_t*)data + header->timestamps_offset),
+                           (const uint8_t*)data + header->lanes_offset, (const uint8_t*)data + header->notes_offset, count)) {
+        printf("Mapa compilado '%s' invalido.\n", filename);
+        munmap(data, st.st_size);
+        return -1;
+    }
+
+    chart->header = header;
+    chart->timestamps = (const float*)((const uint8_t*)data + header->timestamps_offset);
+    chart->lanes = (const uint8_t*)data + header->lanes_offset;
+    chart->notes = (const uint8_t*)data + header->notes_offset;
+    chart->note_count = count;
+    chart->size = st.st_size;
+    return 0;
+}
+
+void chart_unmap_compiled(CompiledChart* chart) {
+    if (chart->header) munmap((void*)chart->header, chart->size);
+    memset(chart, 0, sizeof(*chart));
+}
@@ -0,0 +1,96 @@
+#ifndef MAPA_COMPILADO_H
+#define MAPA_COMPILADO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Compiled chart (.ghc): a fixed header followed by note arrays the game can mmap and
+// use in place. All arrays hold note_count entries, sorted by timestamp, and start on a
+// CHART_ALIGN boundary. Fields are little-endian (x86 on both the analyzer and the board).
+#define CHART_MAGIC 0x4D434847u   // "GHCM"
+#define CHART_VERSION 1
+#define CHART_ALIGN 16
+#define CHART_EXTENSION ".ghc"
+#define CHART_NUM_NOTES 48   // C2..B5, NUM_NOTES in mapeamento_audio.h
+#define CHART_NUM_LANES 4
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t note_count;
+    uint32_t timestamps_offset;   // float[note_count], seconds
+    uint32_t lanes_offset;        // uint8_t[note_count], chart_lane_for_note of the note
+    uint32_t notes_offset;        // uint8_t[note_count], index in the C2..B5 scale, < CHART_NUM_NOTES
+    uint32_t file_size;
+    uint32_t reserved;
+} ChartHeader;
+
+// Lane of a note in the C2..B5 scale, the same split carregar_nivel does on the
+// note letter: C/D -> 0, E/F -> 1, G/A -> 2, B -> 3
+static inline uint8_t chart_lane_for_note(int note) {
+    static const uint8_t lanes[12] = { 0, 0, 0, 0, 1, 1, 1, 2, 2, 2, 2, 3 };
+    return lanes[note % 12];
+}
+
+// "C2".."B5" for a note index; out must hold 5 bytes
+static inline void chart_note_name(int note, char* out) {
+    static const char pitch[12][2] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+    int n = 0;
+    out[n++] = pitch[note % 12][0];
+    if (pitch[note % 12][1]) out[n++] = '#';
+    out[n++] = (char)('2' + note / 12);
+    out[n] = '\0';
+}
+
+// Index of a note name in the C2..B5 scale, -1 if it is not one (E# and B# are not: the
+// analyzer never writes them, and B#5 would be past the scale)
+static inline int chart_note_from_name(const char* name) {
+    static const int base[7] = { 9, 11, 0, 2, 4, 5, 7 };   // A B C D E F G
+    if (name[0] < 'A' || name[0] > 'G') return -1;
+    int pitch = base[name[0] - 'A'];
+    const char* p = name + 1;
+    if (*p == '#') {
+        if (name[0] == 'E' || name[0] == 'B') return -1;
+        pitch++;
+        p++;
+    }
+    if (*p < '2' || *p > '5' || p[1] != '\0') return -1;
+    return (*p - '2') * 12 + pitch;
+}
+
+static inline uint32_t chart_align(uint32_t offset) {
+    return (offset + CHART_ALIGN - 1) & ~(uint32_t)(CHART_ALIGN - 1);
+}
+
+// Writes a compiled chart. Timestamps must already be sorted. Returns 0 on success, -1 without
+// writing anything if a note is outside the scale or the timestamps are not in order.
+int chart_write_compiled(const char* filename, const float* timestamps, const uint8_t* notes, uint32_t note_count);
+
+// Stable sort by timestamp, values moving with their timestamps, for text charts that may be
+// hand-edited: one check for a chart already in order, otherwise a merge sort with a scratch
+// copy. Returns -1 if the scratch can't be allocated (the arrays are then untouched).
+int chart_sort_by_time(float* timestamps, uint8_t* values, uint32_t count);
+
+// Text chart ("tempo<TAB>nota" per line, as written by the analyzer) to compiled chart and back
+int chart_compile_text(const char* text_filename, const char* compiled_filename);
+int chart_export_text(const char* compiled_filename, const char* text_filename);
+
+// Read-only view of a compiled chart mapped straight from the file
+typedef struct {
+    const ChartHeader* header;
+    const float* timestamps;
+    const uint8_t* lanes;
+    const uint8_t* notes;
+    uint32_t note_count;
+    size_t size;
+} CompiledChart;
+
+// Maps and validates a compiled chart. Returns 0 on success, -1 if it can't be
+// opened or is not a valid chart (magic, version, offsets, or note data: every note in the
+// scale with its own lane, timestamps sorted). The game indexes tables with the lanes and
+// notes, so nothing past this check can be out of range.
+int chart_map_compiled(const char* filename, CompiledChart* chart);
+void chart_unmap_compiled(CompiledChart* chart);
+
+#endif // MAPA_COMPILADO_H
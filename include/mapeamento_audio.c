@@ -1,25 +1,40 @@
 #define MINIMP3_IMPLEMENTATION
 #include "minimp3.h"
-#include "kiss_fft.h"
+#include "kiss_fftr.h"
+#include "pico_espectral.h"
 #include "mapeamento_audio.h"
+#include "analise_mdct.h"
+#include "decodificacao_paralela.h"
+#include "indice_mp3.h"
+#include "banco_notas.h"
+#include "fft_lotes.h"
 #include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-const char* NOTES[NUM_NOTES] = {
+// Read-only tables: the analyzer keeps no mutable global state, so plans on different
+// threads never share anything
+static const char* const NOTES[NUM_NOTES] = {
     "C2", "C#2", "D2", "D#2", "E2", "F2", "F#2", "G2", "G#2", "A2", "A#2", "B2",
     "C3", "C#3", "D3", "D#3", "E3", "F3", "F#3", "G3", "G#3", "A3", "A#3", "B3",
     "C4", "C#4", "D4", "D#4", "E4", "F4", "F#4", "G4", "G#4", "A4", "A#4", "B4",
     "C5", "C#5", "D5", "D#5", "E5", "F5", "F#5", "G5", "G#5", "A5", "A#5", "B5"
 };
 
-const float FREQS[NUM_NOTES] = {
+static const float FREQS[NUM_NOTES] = {
     65.41, 69.30, 73.42, 77.78, 82.41, 87.31, 92.50, 98.00, 103.83, 110.00, 116.54, 123.47,
     130.81, 138.59, 146.83, 155.56, 164.81, 174.61, 185.00, 196.00, 207.65, 220.00, 233.08, 246.94,
     261.63, 277.18, 293.66, 311.13, 329.63, 349.23, 369.99, 392.00, 415.30, 440.00, 466.16, 493.88,
     523.25, 554.37, 587.33, 622.25, 659.25, 698.46, 739.99, 783.99, 830.61, 880.00, 932.33, 987.77
 };
 
-static const char* freq_to_note(float freq) {
-    if (freq < FREQS[0] * 0.97) return NULL;
+// Index in NOTES of the note closest to freq, NOTE_NONE if it is more than 5% off
+static int freq_to_note(float freq) {
+    if (freq < FREQS[0] * 0.97) return NOTE_NONE;
     float min_diff = 1e9;
     int note_idx = -1;
 
@@ -32,9 +47,106 @@ static const char* freq_to_note(float freq) {
     }
     
     if (note_idx != -1 && min_diff < FREQS[note_idx] * 0.05) {
-        return NOTES[note_idx];
+        return note_idx;
     }
-    return NULL;
+    return NOTE_NONE;
+}
+
+// The peak frequency is a function of the bin index alone, so the note search runs
+// once per bin here instead of once per frame
+void build_bin_note_table(signed char* bin_notes, int sample_rate) {
+    for (int i = 0; i < FRAME_SIZE / 2; i++) {
+        float freq = (float)i * sample_rate / FRAME_SIZE;
+        bin_notes[i] = (signed char)freq_to_note(freq);
+    }
+}
+
+static uint32_t read_be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Frame count stored in a Xing/Info (LAME) or VBRI (Fraunhofer) tag, 0 if the frame has none
+static uint32_t vbr_tag_frames(const uint8_t* hdr, int frame_bytes) {
+    if (HDR_GET_LAYER(hdr) != 1) return 0;
+
+    int side_info = HDR_TEST_MPEG1(hdr) ? (HDR_IS_MONO(hdr) ? 17 : 32) : (HDR_IS_MONO(hdr) ? 9 : 17);
+    const uint8_t* tag = hdr + HDR_SIZE + (HDR_IS_CRC(hdr) ? 2 : 0) + side_info;
+    if (tag + 12 <= hdr + frame_bytes &&
+        (!memcmp(tag, "Xing", 4) || !memcmp(tag, "Info", 4)) && (tag[7] & 1)) {
+        return read_be32(tag + 8);
+    }
+
+    tag = hdr + HDR_SIZE + 32;
+    if (tag + 18 <= hdr + frame_bytes && !memcmp(tag, "VBRI", 4)) {
+        return read_be32(tag + 14);
+    }
+    return 0;
+}
+
+// Upper bound on the interleaved sample count, taken from the VBR tag when there is
+// one and otherwise by hopping from header to header. Nothing is decoded here.
+size_t estimate_pcm_samples(const unsigned char* mp3, long mp3_size) {
+    int free_format_bytes = 0, frame_bytes = 0;
+    long pos = mp3d_find_frame(mp3, mp3_size, &free_format_bytes, &frame_bytes);
+    if (!frame_bytes) return 0;
+
+    const uint8_t* first = mp3 + pos;
+    int channels = HDR_IS_MONO(first) ? 1 : 2;
+    uint32_t tag_frames = vbr_tag_frames(first, frame_bytes);
+    if (tag_frames) {
+        // The tag frame itself decodes to silence, so count it too
+        return ((size_t)tag_frames + 1) * hdr_frame_samples(first) * channels;
+    }
+    return count_pcm_samples(mp3, mp3_size);
+}
+
+// The header walk alone, whatever a VBR tag claims: the decoder does not trust the tag
+// either, so a file whose tag under-reports (cut or re-tagged) still fits
+size_t count_pcm_samples(const unsigned char* mp3, long mp3_size) {
+    int free_format_bytes = 0, frame_bytes = 0;
+    long pos = mp3d_find_frame(mp3, mp3_size, &free_format_bytes, &frame_bytes);
+    size_t total = 0;
+    while (frame_bytes && pos + frame_bytes <= mp3_size) {
+        const uint8_t* hdr = mp3 + pos;
+        total += (size_t)hdr_frame_samples(hdr) * (HDR_IS_MONO(hdr) ? 1 : 2);
+        pos += frame_bytes;
+
+        if (pos + HDR_SIZE <= mp3_size && hdr_compare(hdr, mp3 + pos)) {
+            frame_bytes = hdr_frame_bytes(mp3 + pos, free_format_bytes) + hdr_padding(mp3 + pos);
+        } else {
+            // Lost sync (junk or a tag in the middle), search like the decoder does
+            free_format_bytes = 0;
+            pos += mp3d_find_frame(mp3 + pos, mp3_size - pos, &free_format_bytes, &frame_bytes);
+        }
+    }
+    return total;
+}
+
+// Decodes every frame into *pcm, which holds *capacity samples and is doubled with realloc
+// if that falls short (counted in *grows when it is not NULL). info gets the format of the
+// last frame looked at. Returns the interleaved samples, -1 if the buffer could not grow.
+static long decode_all_frames(const unsigned char* mp3, long mp3_size, short** pcm, size_t* capacity,
+                              mp3dec_frame_info_t* info, long* grows) {
+    mp3dec_t dec;
+    mp3dec_init(&dec);
+    size_t pcm_size = 0;
+
+    for (;;) {
+        // The estimate is an upper bound for well-formed files; grow only if a broken tag lied
+        if (*capacity - pcm_size < MINIMP3_MAX_SAMPLES_PER_FRAME) {
+            short* grown = (short*)realloc(*pcm, *capacity * 2 * sizeof(short));
+            if (!grown) return -1;
+            *pcm = grown;
+            *capacity *= 2;
+            if (grows) (*grows)++;
+        }
+        int samples = mp3dec_decode_frame(&dec, mp3, mp3_size, *pcm + pcm_size, info);
+        if (samples <= 0) break;
+        pcm_size += samples * info->channels;
+        mp3 += info->frame_bytes;
+        mp3_size -= info->frame_bytes;
+    }
+    return (long)pcm_size;
 }
 
 AudioData* load_mp3_file(const char* filename) {
@@ -63,21 +175,10 @@ AudioData* load_mp3_file(const char* filename) {
     }
     fclose(f);
 
-    mp3dec_t dec;
-    mp3dec_init(&dec);
-    mp3dec_frame_info_t info;
+    mp3dec_frame_info_t info = {0};  // stays zeroed if no frame decodes
     
-    // Calculate needed size
-    size_t total_pcm_samples = 0;
-    unsigned char *mp3_ptr = mp3_buffer_orig;
-    long file_size_remaining = file_size;
-    int samples = 0;
-
-    while ((samples = mp3dec_decode_frame(&dec, mp3_ptr, file_size_remaining, NULL, &info)) > 0) {
-        total_pcm_samples += samples * info.channels;
-        mp3_ptr += info.frame_bytes;
-        file_size_remaining -= info.frame_bytes;
-    }
+    // Size the PCM buffer from the frame headers, no decoding needed
+    size_t pcm_capacity = estimate_pcm_samples(mp3_buffer_orig, file_size) + MINIMP3_MAX_SAMPLES_PER_FRAME;
 
     // Allocate memory and decode
     AudioData* audio_data = (AudioData*)malloc(sizeof(AudioData));
@@ -87,7 +188,7 @@ AudioData* load_mp3_file(const char* filename) {
         return NULL;
     }
 
-    audio_data->pcm_buffer = (short*)malloc(total_pcm_samples * sizeof(short));
+    audio_data->pcm_buffer = (short*)malloc(pcm_capacity * sizeof(short));
     if (!audio_data->pcm_buffer) {
         printf("Erro ao alocar memoria para o buffer PCM.\n");
         free(mp3_buffer_orig);
@@ -95,19 +196,13 @@ AudioData* load_mp3_file(const char* filename) {
         return NULL;
     }
 
-    size_t pcm_size = 0;
-    mp3dec_init(&dec);
-    mp3_ptr = mp3_buffer_orig;
-    file_size_remaining = file_size;
-    
-    while ((samples = mp3dec_decode_frame(&dec, mp3_ptr, file_size_remaining, 
-                                         audio_data->pcm_buffer + pcm_size, &info)) > 0) {
-        pcm_size += samples * info.channels;
-        mp3_ptr += info.frame_bytes;
-        file_size_remaining -= info.frame_bytes;
-    }
-
+    long pcm_size = decode_all_frames(mp3_buffer_orig, file_size, &audio_data->pcm_buffer, &pcm_capacity, &info, NULL);
     free(mp3_buffer_orig);
+    if (pcm_size < 0) {
+        printf("Erro ao alocar memoria para o buffer PCM.\n");
+        free_audio_data(audio_data);
+        return NULL;
+    }
     
     audio_data->pcm_size = pcm_size;
     audio_data->sample_rate = info.hz;
@@ -125,60 +220,898 @@ void free_audio_data(AudioData* audio_data) {
     }
 }
 
-void analyze_audio_to_file(AudioData* audio_data, const char* output_filename) {
-    if (!audio_data || !output_filename) return;
+// Per-frame note detection shared by the in-memory and the streaming analyzers
+typedef struct {
+    kiss_fftr_cfg cfg;
+    int owns_cfg;
+    int verbose;
+    FILE* output;                            // NULL when notes only go to sink
+    const NoteSink* sink;
+    int sample_rate;
+    int channels;
+    WindowType window_type;
+    int hop_size;                            // samples per channel between window starts
+    long pcm_base;                           // song offset of pcm_offset 0 when analyzing a range
+    long emit_from;                          // song offset of the first window written out; the
+                                             // range's lead-in before it only sets ultima_nota_encontrada
+    int ultima_nota_encontrada;
+    AnalysisEngine engine;                   // FFT, or one of the note bank's (MDCT never gets here)
+    NoteBank* bank;                          // allocated on the first window it analyzes
+    int owns_bank;
+    long bank_offset;                        // last window the sliding DFT saw, -1 before any
+    FftBatch* batch;                         // FFT engine: windows transformed FFT_BATCH_LANES at a time
+    int owns_batch;
+    signed char bin_notes[FRAME_SIZE / 2];   // FFT bin -> note index, for sample_rate
+    float window[FRAME_SIZE];                // analysis window for channels, with the int16 scale
+} NoteDetector;
 
-    kiss_fft_cfg cfg = kiss_fft_alloc(FRAME_SIZE, 0, NULL, NULL);
-    kiss_fft_cpx in[FRAME_SIZE];
-    kiss_fft_cpx out[FRAME_SIZE];
-    FILE* output = fopen(output_filename, "w");
+static const AnalysisOptions default_options = ANALYSIS_OPTIONS_DEFAULT;
 
-    if (!output) {
+// shared_cfg lets a caller reuse one FFT plan across songs; NULL allocates a private one
+// in note_detector_start, so a detector that never starts needs no plan.
+// options only supplies the window, hop and engine (NULL: rectangular, hop = FRAME_SIZE, FFT).
+static int note_detector_open(NoteDetector* det, const char* output_filename, kiss_fftr_cfg shared_cfg,
+                              const AnalysisOptions* options) {
+    det->owns_cfg = shared_cfg == NULL;
+    det->cfg = shared_cfg;
+    det->sink = NULL;
+    det->output = output_filename ? fopen(output_filename, "w") : NULL;
+    if (output_filename && !det->output) {
         printf("Erro ao abrir arquivo de saída '%s'!\n", output_filename);
-        kiss_fft_free(cfg);
-        return;
+        if (det->owns_cfg) kiss_fftr_free(det->cfg);
+        return -1;
     }
+    det->verbose = 1;
+    det->sample_rate = 0;
+    det->channels = 0;
+    if (!options) options = &default_options;
+    det->window_type = options->window;
+    det->hop_size = options->hop_size >= 1 && options->hop_size <= FRAME_SIZE ? options->hop_size : FRAME_SIZE;
+    det->pcm_base = 0;
+    det->emit_from = 0;
+    det->ultima_nota_encontrada = NOTE_NONE;
+    det->engine = options->engine;
+    det->bank = NULL;
+    det->owns_bank = 0;
+    det->bank_offset = -1;
+    det->batch = NULL;
+    det->owns_batch = 0;
+    return 0;
+}
 
-    printf("Analisando áudio com taxa de amostragem de %d Hz...\n", audio_data->sample_rate);
-    
-    char ultima_nota_encontrada[5] = "";
+static void note_detector_start(NoteDetector* det, int sample_rate, int channels) {
+    det->sample_rate = sample_rate;
+    det->channels = channels;
+    if (!det->cfg) det->cfg = kiss_fftr_alloc(FRAME_SIZE, 0, NULL, NULL);
+    build_bin_note_table(det->bin_notes, sample_rate);
+    window_build(det->window, FRAME_SIZE, det->window_type, channels);
+    if (det->verbose) printf("Analisando áudio com taxa de amostragem de %d Hz...\n", sample_rate);
+}
+
+// Finds the dominant note of one FRAME_SIZE window of interleaved PCM, NOTE_NONE if there is none
+static int detect_frame_note(kiss_fftr_cfg cfg, const signed char* bin_notes, const float* window,
+                             const short* frame, int channels) {
+    // Real input: only bins 0..FRAME_SIZE/2 are computed
+    kiss_fft_scalar in[FRAME_SIZE];
+    kiss_fft_cpx out[FRAME_SIZE / 2 + 1];
+
+    window_apply(frame, channels, window, in, FRAME_SIZE);
+    kiss_fftr(cfg, in, out);
+
+    // Peak on squared magnitudes; only the winning bin gets a sqrt for the threshold
+    float max_sq;
+    int max_idx = spectrum_peak(out, 1, FRAME_SIZE / 2, &max_sq);
     
-    for (long pcm_offset = 0; 
+    if (sqrtf(max_sq) > THRESHOLD) {
+        return bin_notes[max_idx];
+    }
+    return NOTE_NONE;
+}
+
+// detect_frame_note on count <= FFT_BATCH_LANES windows, frame_step samples apart, with one
+// batched transform (fft_lotes.h): the notes are the ones detect_frame_note finds
+static void detect_batch_notes(FftBatch* batch, const signed char* bin_notes, const float* window,
+                               const short* frame, long frame_step, int count, int channels, signed char* notes) {
+    int peak[FFT_BATCH_LANES];
+    float peak_sq[FFT_BATCH_LANES];
+    for (int l = 0; l < count; l++) {
+        window_apply(frame + l * frame_step, channels, window, fft_batch_lane(batch, l), FRAME_SIZE);
+    }
+    fft_batch_peaks(batch, count, 1, FRAME_SIZE / 2, peak, peak_sq);
+    for (int l = 0; l < count; l++) {
+        notes[l] = (signed char)(sqrtf(peak_sq[l]) > THRESHOLD ? bin_notes[peak[l]] : NOTE_NONE);
+    }
+}
+
+// Writes the note found in the window at pcm_offset, unless it repeats the previous one
+static void note_detector_emit(NoteDetector* det, int note, long pcm_offset) {
+    if (note != NOTE_NONE) {
+        if (det->pcm_base + pcm_offset < det->emit_from) {
+            det->ultima_nota_encontrada = note;
+        } else if (note != det->ultima_nota_encontrada) {
+            double time = (double)(det->pcm_base + pcm_offset) / (det->channels * det->sample_rate);
+            if (det->output) fprintf(det->output, "%.2f\t%s\n", time, NOTES[note]);
+            if (det->sink && det->sink->on_note) det->sink->on_note(det->sink->user, time, note);
+            det->ultima_nota_encontrada = note;
+        }
+    }
+}
+
+// Same peak -> THRESHOLD -> bin_notes decision as detect_frame_note, from the note bank
+// (banco_notas.h): only the bins a note can be in are evaluated, so a peak above them no
+// longer hides a weaker note below it
+static int detect_bank_note(NoteDetector* det, const short* frame, long pcm_offset) {
+    if (!det->bank) {
+        det->bank = note_bank_alloc(det->bin_notes, FRAME_SIZE, det->window_type, det->channels);
+        if (!det->bank) return NOTE_NONE;
+        det->owns_bank = 1;
+    }
+    float max_sq;
+    int max_idx;
+    if (det->engine == ANALYSIS_ENGINE_SDFT) {
+        // The next window on the hop grid brings hop new samples; anything else starts over
+        long step = (long)det->hop_size * det->channels;
+        int fresh = det->bank_offset >= 0 && pcm_offset - det->bank_offset == step ? det->hop_size : FRAME_SIZE;
+        det->bank_offset = pcm_offset;
+        max_idx = note_bank_slide_peak(det->bank, frame, fresh, &max_sq);
+    } else {
+        kiss_fft_scalar in[FRAME_SIZE];
+        window_apply(frame, det->channels, det->window, in, FRAME_SIZE);
+        max_idx = note_bank_block_peak(det->bank, in, &max_sq);
+    }
+    if (sqrtf(max_sq) > THRESHOLD) {
+        return det->bin_notes[max_idx];
+    }
+    return NOTE_NONE;
+}
+
+static void note_detector_process(NoteDetector* det, const short* frame, long pcm_offset) {
+    int note = det->engine == ANALYSIS_ENGINE_GOERTZEL || det->engine == ANALYSIS_ENGINE_SDFT
+             ? detect_bank_note(det, frame, pcm_offset)
+             : detect_frame_note(det->cfg, det->bin_notes, det->window, frame, det->channels);
+    note_detector_emit(det, note, pcm_offset);
+}
+
+static void note_detector_close(NoteDetector* det, const char* output_filename) {
+    if (det->owns_cfg) kiss_fftr_free(det->cfg);
+    if (det->owns_bank) note_bank_free(det->bank);
+    if (det->owns_batch) fft_batch_free(det->batch);
+    if (!det->output) return;
+    fclose(det->output);
+    if (det->verbose) printf("Notas salvas em '%s'!\n", output_filename);
+}
+
+static void note_detector_run(NoteDetector* det, const AudioData* audio_data) {
+    long pcm_offset = 0;
+    if (det->engine == ANALYSIS_ENGINE_FFT) {
+        if (!det->batch) {
+            det->batch = fft_batch_alloc(FRAME_SIZE);
+            det->owns_batch = 1;
+        }
+        // Whole batches while they fit; the last few windows (and all of them without a
+        // batch) go through the per-frame loop below
+        long window_size = (long)FRAME_SIZE * audio_data->channels;
+        long frame_step = (long)det->hop_size * audio_data->channels;
+        long batch_span = (FFT_BATCH_LANES - 1) * frame_step + window_size;
+        for (; det->batch && pcm_offset + batch_span < (long)audio_data->pcm_size;
+             pcm_offset += FFT_BATCH_LANES * frame_step) {
+            signed char notes[FFT_BATCH_LANES];
+            detect_batch_notes(det->batch, det->bin_notes, det->window, audio_data->pcm_buffer + pcm_offset,
+                               frame_step, FFT_BATCH_LANES, audio_data->channels, notes);
+            for (int l = 0; l < FFT_BATCH_LANES; l++) {
+                note_detector_emit(det, notes[l], pcm_offset + l * frame_step);
+            }
+        }
+    }
+    for (; 
          pcm_offset + (FRAME_SIZE * audio_data->channels) < audio_data->pcm_size; 
-         pcm_offset += (FRAME_SIZE * audio_data->channels)) {
-        
-        for (int i = 0; i < FRAME_SIZE; i++) {
-            if (audio_data->channels == 2) {
-                in[i].r = (float)(audio_data->pcm_buffer[pcm_offset + i*2] + 
-                                  audio_data->pcm_buffer[pcm_offset + i*2 + 1]) / 2.0f / 32768.0f;
-            } else {
-                in[i].r = (float)audio_data->pcm_buffer[pcm_offset + i] / 32768.0f;
+         pcm_offset += (det->hop_size * audio_data->channels)) {
+        note_detector_process(det, audio_data->pcm_buffer + pcm_offset, pcm_offset);
+    }
+}
+
+void analyze_audio_to_file(AudioData* audio_data, const char* output_filename) {
+    if (!audio_data || !output_filename) return;
+
+    NoteDetector det;
+    if (note_detector_open(&det, output_filename, NULL, NULL) != 0) return;
+    note_detector_start(&det, audio_data->sample_rate, audio_data->channels);
+    
+    note_detector_run(&det, audio_data);
+
+    note_detector_close(&det, output_filename);
+}
+
+struct AnalysisPlan {
+    kiss_fftr_cfg cfg;
+    FftBatch* batch;            // NULL without SSE2: the FFT then runs frame by frame
+    AnalysisOptions options;
+    // Note bank engines: bins for bank_rate, downmix for bank_channels; rebuilt when they change
+    NoteBank* bank;
+    int bank_rate;
+    int bank_channels;
+    // Grow-only buffers, sized by the largest song so far and kept for the next one
+    short* pcm;
+    size_t pcm_capacity;        // samples
+    char* text;                 // chart of the song being analyzed, written out in one go
+    size_t text_capacity;
+    size_t text_size;
+    int text_failed;
+    size_t fft_bytes;
+    AnalysisPlanStats stats;
+};
+
+AnalysisPlan* analysis_plan_alloc(const AnalysisOptions* options) {
+    AnalysisPlan* plan = (AnalysisPlan*)calloc(1, sizeof(AnalysisPlan));
+    if (!plan) return NULL;
+    plan->options = options ? *options : default_options;
+    plan->cfg = kiss_fftr_alloc(FRAME_SIZE, 0, NULL, NULL);
+    if (!plan->cfg) {
+        free(plan);
+        return NULL;
+    }
+    kiss_fftr_alloc(FRAME_SIZE, 0, NULL, &plan->fft_bytes);   // only reports the size
+    plan->stats.allocations = 2;
+    plan->batch = fft_batch_alloc(FRAME_SIZE);
+    if (plan->batch) plan->stats.allocations++;
+    return plan;
+}
+
+void analysis_plan_free(AnalysisPlan* plan) {
+    if (plan) {
+        kiss_fftr_free(plan->cfg);
+        fft_batch_free(plan->batch);
+        note_bank_free(plan->bank);
+        free(plan->pcm);
+        free(plan->text);
+        free(plan);
+    }
+}
+
+void analysis_plan_stats(const AnalysisPlan* plan, AnalysisPlanStats* stats) {
+    *stats = plan->stats;
+    stats->reserved_bytes = sizeof(AnalysisPlan) + plan->fft_bytes + fft_batch_bytes(plan->batch) +
+                            note_bank_bytes(plan->bank) + plan->pcm_capacity * sizeof(short) + plan->text_capacity;
+}
+
+// Makes room for needed items in one of the plan's buffers: at least doubles, so a run of
+// slightly longer songs does not reallocate every time
+static int plan_reserve(AnalysisPlan* plan, void** buffer, size_t* capacity, size_t needed, size_t item_size) {
+    if (*capacity >= needed) return 0;
+    size_t grown_capacity = *capacity * 2 > needed ? *capacity * 2 : needed;
+    void* grown = realloc(*buffer, grown_capacity * item_size);
+    if (!grown) return -1;
+    *buffer = grown;
+    *capacity = grown_capacity;
+    plan->stats.allocations++;
+    return 0;
+}
+
+// Lends a started detector the plan's FFT batch and, for the note bank engines, its bank,
+// built for the detector's sample rate and channels (a bank the plan cannot build is left
+// to the detector, as without a plan)
+static void plan_lend(AnalysisPlan* plan, NoteDetector* det) {
+    det->batch = plan->batch;
+    if (det->engine != ANALYSIS_ENGINE_GOERTZEL && det->engine != ANALYSIS_ENGINE_SDFT) return;
+    if (plan->bank && (plan->bank_rate != det->sample_rate || plan->bank_channels != det->channels)) {
+        note_bank_free(plan->bank);
+        plan->bank = NULL;
+    }
+    if (!plan->bank) {
+        plan->bank = note_bank_alloc(det->bin_notes, FRAME_SIZE, plan->options.window, det->channels);
+        if (!plan->bank) return;
+        plan->bank_rate = det->sample_rate;
+        plan->bank_channels = det->channels;
+        plan->stats.allocations++;
+    }
+    det->bank = plan->bank;
+}
+
+#define CHART_LINE_BYTES 16   // "%.2f\t%s\n" for a note within the first ~3 hours
+
+// NoteSink for analyze_mp3_with_plan: the same line note_detector_emit writes, into plan->text
+static void plan_append_note(void* user, double time, int note) {
+    AnalysisPlan* plan = (AnalysisPlan*)user;
+    for (;;) {
+        size_t room = plan->text_capacity - plan->text_size;
+        int n = snprintf(plan->text + plan->text_size, room, "%.2f\t%s\n", time, NOTES[note]);
+        if (n < 0) break;
+        if ((size_t)n < room) {
+            plan->text_size += n;
+            return;
+        }
+        if (plan_reserve(plan, (void**)&plan->text, &plan->text_capacity, plan->text_size + n + 1, 1) != 0) break;
+    }
+    plan->text_failed = 1;
+}
+
+static int write_whole_file(const char* filename, const char* data, size_t size) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written <= 0) {
+            close(fd);
+            return -1;
+        }
+        data += written;
+        size -= written;
+    }
+    return close(fd);
+}
+
+int analyze_mp3_with_plan(AnalysisPlan* plan, const char* mp3_filename, const char* output_filename) {
+    if (!plan || !mp3_filename || !output_filename) return -1;
+    plan->stats.audio_seconds = 0;
+
+    // mmapped instead of read into a buffer: the song's bytes never touch the heap
+    int fd = open(mp3_filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Erro ao abrir o arquivo '%s'!\n", mp3_filename);
+        return -1;
+    }
+    struct stat st;
+    const unsigned char* mp3 = NULL;
+    int mapped = fstat(fd, &st) == 0;
+    if (mapped && st.st_size > 0) {
+        void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        mapped = data != MAP_FAILED;
+        if (mapped) mp3 = (const unsigned char*)data;
+    }
+    close(fd);
+    if (!mapped) {
+        printf("Erro ao ler o arquivo '%s'!\n", mp3_filename);
+        return -1;
+    }
+
+    size_t needed = estimate_pcm_samples(mp3, st.st_size) + MINIMP3_MAX_SAMPLES_PER_FRAME;
+    mp3dec_frame_info_t info = {0};
+    long pcm_size = -1;
+    if (plan_reserve(plan, (void**)&plan->pcm, &plan->pcm_capacity, needed, sizeof(short)) == 0) {
+        pcm_size = decode_all_frames(mp3, st.st_size, &plan->pcm, &plan->pcm_capacity, &info, &plan->stats.allocations);
+    }
+    if (mp3) munmap((void*)mp3, st.st_size);
+    if (pcm_size < 0) {
+        printf("Erro ao alocar memoria para o buffer PCM.\n");
+        return -1;
+    }
+
+    AudioData audio_data = { plan->pcm, (size_t)pcm_size, info.hz, info.channels };
+    if (info.hz > 0 && info.channels > 0) {
+        plan->stats.audio_seconds = (double)pcm_size / (info.channels * info.hz);
+    }
+    // At most one note per window, so the chart rarely outgrows this
+    int hop_size = plan->options.hop_size >= 1 && plan->options.hop_size <= FRAME_SIZE ? plan->options.hop_size : FRAME_SIZE;
+    size_t max_lines = info.channels > 0 ? (size_t)pcm_size / ((size_t)hop_size * info.channels) + 1 : 1;
+    if (plan_reserve(plan, (void**)&plan->text, &plan->text_capacity, max_lines * CHART_LINE_BYTES, 1) != 0) {
+        printf("Erro ao alocar memoria para o mapa de '%s'.\n", mp3_filename);
+        return -1;
+    }
+
+    NoteSink sink = { plan_append_note, NULL, plan };
+    NoteDetector det;
+    note_detector_open(&det, NULL, plan->cfg, &plan->options);
+    det.verbose = 0;
+    det.sink = &sink;
+    plan->text_size = 0;
+    plan->text_failed = 0;
+    note_detector_start(&det, audio_data.sample_rate, audio_data.channels);
+    plan_lend(plan, &det);
+    note_detector_run(&det, &audio_data);
+    note_detector_close(&det, output_filename);   // no file of its own, nothing to close
+
+    if (plan->text_failed) {
+        printf("Erro ao alocar memoria para o mapa de '%s'.\n", mp3_filename);
+        return -1;
+    }
+    if (write_whole_file(output_filename, plan->text, plan->text_size) != 0) {
+        printf("Erro ao escrever o arquivo '%s'!\n", output_filename);
+        return -1;
+    }
+    plan->stats.songs++;
+    return 0;
+}
+
+int analyze_audio_with_plan(AudioData* audio_data, const char* output_filename, AnalysisPlan* plan) {
+    if (!audio_data || !output_filename || !plan) return -1;
+
+    NoteDetector det;
+    if (note_detector_open(&det, output_filename, plan->cfg, &plan->options) != 0) return -1;
+    det.verbose = 0;
+    note_detector_start(&det, audio_data->sample_rate, audio_data->channels);
+    plan_lend(plan, &det);
+
+    note_detector_run(&det, audio_data);
+
+    note_detector_close(&det, output_filename);
+    return 0;
+}
+
+// A contiguous range of frames analyzed by one worker thread with its own FFT plan and batch
+typedef struct {
+    const AudioData* audio_data;
+    long first_frame;
+    long end_frame;
+    long frame_step;                 // interleaved samples between window starts
+    const signed char* bin_notes;
+    const float* window;
+    signed char* frame_notes;
+} FrameRangeJob;
+
+static void* analyze_frame_range(void* arg) {
+    FrameRangeJob* job = (FrameRangeJob*)arg;
+    const AudioData* audio_data = job->audio_data;
+    kiss_fftr_cfg cfg = kiss_fftr_alloc(FRAME_SIZE, 0, NULL, NULL);
+    FftBatch* batch = fft_batch_alloc(FRAME_SIZE);
+
+    long f = job->first_frame;
+    for (; batch && f < job->end_frame; f += FFT_BATCH_LANES) {
+        int count = job->end_frame - f < FFT_BATCH_LANES ? (int)(job->end_frame - f) : FFT_BATCH_LANES;
+        detect_batch_notes(batch, job->bin_notes, job->window, audio_data->pcm_buffer + f * job->frame_step,
+                           job->frame_step, count, audio_data->channels, job->frame_notes + f);
+    }
+    for (; f < job->end_frame; f++) {
+        job->frame_notes[f] = (signed char)detect_frame_note(cfg, job->bin_notes, job->window,
+                                                             audio_data->pcm_buffer + f * job->frame_step,
+                                                             audio_data->channels);
+    }
+
+    kiss_fftr_free(cfg);
+    fft_batch_free(batch);
+    return NULL;
+}
+
+// pcm_base: where audio_data starts in the song, for the note times; emit_from: the song
+// offset of the first window written out
+static int analyze_audio_from(const AudioData* audio_data, const char* output_filename,
+                              const AnalysisOptions* options, long pcm_base, long emit_from) {
+    NoteDetector det;
+    if (note_detector_open(&det, output_filename, NULL, options) != 0) return -1;
+    det.pcm_base = pcm_base;
+    det.emit_from = emit_from;
+    note_detector_start(&det, audio_data->sample_rate, audio_data->channels);
+
+    // Same frames as the serial loop: a window is used only if a sample follows it
+    long window_size = FRAME_SIZE * audio_data->channels;
+    long frame_step = det.hop_size * audio_data->channels;
+    long num_frames = (long)audio_data->pcm_size > window_size
+                    ? ((long)audio_data->pcm_size - window_size - 1) / frame_step + 1 : 0;
+    int num_threads = options->num_threads;
+    if (num_threads > num_frames) num_threads = num_frames > 0 ? (int)num_frames : 1;
+    if (det.engine == ANALYSIS_ENGINE_GOERTZEL || det.engine == ANALYSIS_ENGINE_SDFT) num_threads = 1;
+
+    if (num_threads <= 1) {
+        note_detector_run(&det, audio_data);
+        note_detector_close(&det, output_filename);
+        return 0;
+    }
+
+    signed char* frame_notes = (signed char*)malloc(num_frames + 1);
+    pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+    FrameRangeJob* jobs = (FrameRangeJob*)malloc(num_threads * sizeof(FrameRangeJob));
+    if (!frame_notes || !threads || !jobs) {
+        printf("Erro ao alocar memoria para a analise paralela.\n");
+        note_detector_close(&det, output_filename);
+        free(frame_notes);
+        free(threads);
+        free(jobs);
+        return -1;
+    }
+
+    for (int t = 0; t < num_threads; t++) {
+        jobs[t].audio_data = audio_data;
+        jobs[t].first_frame = num_frames * t / num_threads;
+        jobs[t].end_frame = num_frames * (t + 1) / num_threads;
+        jobs[t].frame_step = frame_step;
+        jobs[t].bin_notes = det.bin_notes;
+        jobs[t].window = det.window;
+        jobs[t].frame_notes = frame_notes;
+        if (pthread_create(&threads[t], NULL, analyze_frame_range, &jobs[t]) != 0) {
+            // Could not spawn: do this range on the calling thread instead
+            analyze_frame_range(&jobs[t]);
+            jobs[t].audio_data = NULL;
+        }
+    }
+    for (int t = 0; t < num_threads; t++) {
+        if (jobs[t].audio_data) pthread_join(threads[t], NULL);
+    }
+
+    // Repeated-note filtering depends on the previous frame, so it runs in order here
+    for (long f = 0; f < num_frames; f++) {
+        note_detector_emit(&det, frame_notes[f], f * frame_step);
+    }
+
+    note_detector_close(&det, output_filename);
+    free(frame_notes);
+    free(threads);
+    free(jobs);
+    return 0;
+}
+
+int analyze_audio_with_options(AudioData* audio_data, const char* output_filename, const AnalysisOptions* options) {
+    if (!audio_data || !output_filename) return -1;
+    if (!options) options = &default_options;
+    return analyze_audio_from(audio_data, output_filename, options, 0, 0);
+}
+
+// Song offset of the first window at or after start_seconds and from_pcm (where the decoded
+// range begins) on the whole song's hop grid, so a range is analyzed with the same windows
+static long range_first_window(const AnalysisOptions* options, long from_pcm, int sample_rate, int channels,
+                               int hop_size) {
+    long start = (long)(options->start_seconds * sample_rate) * channels;
+    if (start < from_pcm) start = from_pcm;
+    long step = (long)hop_size * channels;
+    return step > 0 ? (start + step - 1) / step * step : start;
+}
+
+// A repeated note is only written when it changes, and a range must not write the note
+// that was already sounding when it starts: the windows of up to RANGE_LEAD_SECONDS before
+// it are analyzed too, only to know the last note found (after a longer silence the range
+// starts as the song does). Song offset of the first of them, on the same hop grid.
+#define RANGE_LEAD_SECONDS 1.0
+
+static long range_lead_window(long first_window, long from_pcm, int sample_rate, int channels, int hop_size) {
+    long step = (long)hop_size * channels;
+    long lead = first_window - (long)(RANGE_LEAD_SECONDS * sample_rate) / hop_size * step;
+    if (lead < from_pcm) lead = step > 0 ? (from_pcm + step - 1) / step * step : from_pcm;
+    return lead;
+}
+
+static double range_lead_start(const AnalysisOptions* options) {
+    return options->start_seconds > RANGE_LEAD_SECONDS ? options->start_seconds - RANGE_LEAD_SECONDS : 0;
+}
+
+// Song offset from which no window is analyzed
+static long range_end(const AnalysisOptions* options, int sample_rate, int channels) {
+    return options->end_seconds > 0 ? (long)(options->end_seconds * sample_rate) * channels : LONG_MAX;
+}
+
+// In-memory analysis of options->start_seconds..end_seconds: only the frames under those
+// windows are decoded, so the cost follows the range and not the song
+static int analyze_mp3_range(const char* mp3_filename, const char* output_filename, const AnalysisOptions* options) {
+    // A window that starts just before the end still needs FRAME_SIZE samples and one past them
+    size_t first_pcm = 0;
+    AudioData* audio_data = load_mp3_range(mp3_filename, range_lead_start(options), options->end_seconds,
+                                           FRAME_SIZE + 1, &first_pcm);
+    if (!audio_data) return -1;
+
+    int hop_size = options->hop_size >= 1 && options->hop_size <= FRAME_SIZE ? options->hop_size : FRAME_SIZE;
+    long first_window = range_first_window(options, (long)first_pcm, audio_data->sample_rate,
+                                           audio_data->channels, hop_size);
+    long lead_window = range_lead_window(first_window, (long)first_pcm, audio_data->sample_rate,
+                                         audio_data->channels, hop_size);
+    size_t skip = lead_window - first_pcm;
+    if (skip > audio_data->pcm_size) skip = audio_data->pcm_size;
+
+    AudioData range = *audio_data;
+    range.pcm_buffer += skip;
+    range.pcm_size -= skip;
+    long end = range_end(options, audio_data->sample_rate, audio_data->channels);
+    if (end != LONG_MAX) {
+        // Windows are used while offset + FRAME_SIZE * channels < pcm_size
+        size_t limit = (end > lead_window ? end - lead_window : 0) + (size_t)FRAME_SIZE * audio_data->channels;
+        if (range.pcm_size > limit) range.pcm_size = limit;
+    }
+
+    int result = analyze_audio_from(&range, output_filename, options, lead_window, first_window);
+    free_audio_data(audio_data);
+    return result;
+}
+
+void analyze_audio_to_file_parallel(AudioData* audio_data, const char* output_filename, int num_threads) {
+    AnalysisOptions options = ANALYSIS_OPTIONS_DEFAULT;
+    options.num_threads = num_threads;
+    analyze_audio_with_options(audio_data, output_filename, &options);
+}
+
+int analyze_decimated_to_file(const DecimatedAudio* audio, const char* output_filename, const AnalysisOptions* options) {
+    if (!audio || !output_filename) return -1;
+    if (!options) options = &default_options;
+
+    // Same frequency resolution as the full-rate FFT: bin i is still i * source_rate / FRAME_SIZE,
+    // so the bin -> note table is shared. A sine's peak shrinks with the FFT size, and so does
+    // the threshold.
+    int fft_size = FRAME_SIZE / audio->factor;
+    float threshold = (float)THRESHOLD / audio->factor;
+    kiss_fftr_cfg cfg = kiss_fftr_alloc(fft_size, 0, NULL, NULL);
+    kiss_fft_scalar* in = (kiss_fft_scalar*)malloc(fft_size * sizeof(kiss_fft_scalar));
+    kiss_fft_cpx* out = (kiss_fft_cpx*)malloc((fft_size / 2 + 1) * sizeof(kiss_fft_cpx));
+    float* window = (float*)malloc(fft_size * sizeof(float));
+    if (!cfg || !in || !out || !window) {
+        printf("Erro ao alocar memoria para a analise decimada.\n");
+        kiss_fftr_free(cfg);
+        free(in);
+        free(out);
+        free(window);
+        return -1;
+    }
+
+    NoteDetector det;
+    if (note_detector_open(&det, output_filename, cfg, options) != 0) {
+        kiss_fftr_free(cfg);
+        free(in);
+        free(out);
+        free(window);
+        return -1;
+    }
+    det.verbose = 0;
+    note_detector_start(&det, audio->source_rate, 1);
+    // The samples are already in [-1, 1): undo the int16 scale window_build folds in
+    window_build(window, fft_size, det.window_type, 1);
+    for (int i = 0; i < fft_size; i++) window[i] *= 32768.0f;
+
+    // The hop in decimated samples; frame k starts at the same time as in the full-rate path
+    long step = det.hop_size / audio->factor > 0 ? det.hop_size / audio->factor : 1;
+    for (long offset = 0; offset + fft_size < (long)audio->size; offset += step) {
+        const float* frame = audio->samples + offset;
+        for (int i = 0; i < fft_size; i++) in[i] = frame[i] * window[i];
+        kiss_fftr(cfg, in, out);
+
+        float max_sq;
+        int max_idx = spectrum_peak(out, 1, fft_size / 2, &max_sq);
+        int note = sqrtf(max_sq) > threshold ? det.bin_notes[max_idx] : NOTE_NONE;
+        note_detector_emit(&det, note, offset * audio->factor);
+    }
+
+    note_detector_close(&det, output_filename);
+    kiss_fftr_free(cfg);
+    free(in);
+    free(out);
+    free(window);
+    return 0;
+}
+
+// Granule g of the MDCT reader is centred near PCM sample g * 576 + MDCT_GRANULE_DELAY:
+// half of the IMDCT overlap-add (576) plus the synthesis filterbank's delay (~240)
+#define MDCT_GRANULE_DELAY 816
+
+// Dominant note of one frame's summed line powers (granules of them), NOTE_NONE if there is none
+static int mdct_frame_note(const float* power, int granules, int sample_rate) {
+    int peak = 1;
+    for (int i = 2; i < MDCT_GRANULE_LINES - 1; i++) {
+        if (power[i] > power[peak]) peak = i;
+    }
+
+    // A line of value v synthesizes a sine of about 2v full scale, whose FRAME_SIZE-point
+    // FFT peak is about v * FRAME_SIZE: THRESHOLD carries over to the line's RMS
+    if (sqrtf(power[peak] / granules) * FRAME_SIZE <= THRESHOLD) return NOTE_NONE;
+
+    // Lines are ~38 Hz apart at 44.1 kHz; a parabola through the neighbouring magnitudes
+    // places the peak between line centres
+    float a = sqrtf(power[peak - 1]), b = sqrtf(power[peak]), c = sqrtf(power[peak + 1]);
+    float curvature = a - 2 * b + c;
+    float offset = curvature < 0 ? 0.5f * (a - c) / curvature : 0;
+    return freq_to_note((peak + 0.5f + offset) * sample_rate / (2 * MDCT_GRANULE_LINES));
+}
+
+int analyze_mdct_to_file(const char* mp3_filename, const char* output_filename, const AnalysisOptions* options) {
+    if (!mp3_filename || !output_filename) return -1;
+    MdctReader* reader = mdct_reader_open(mp3_filename);
+    if (!reader) return -1;
+
+    NoteDetector det;
+    if (note_detector_open(&det, output_filename, NULL, options) != 0) {
+        mdct_reader_close(reader);
+        return -1;
+    }
+    det.verbose = 0;
+    det.channels = 1;   // offsets below count samples per channel
+
+    // Granules are summed per FRAME_SIZE frame of the FFT analyzer (no hop or window),
+    // so both charts stamp notes on the same grid
+    float power[MDCT_GRANULE_LINES], sum[MDCT_GRANULE_LINES];
+    memset(sum, 0, sizeof(sum));
+    int summed = 0;
+    long frame = 0, granules = 0;
+    int status;
+    while ((status = mdct_reader_next(reader, power)) == 1) {
+        det.sample_rate = mdct_reader_sample_rate(reader);
+        long center = granules * MDCT_GRANULE_LINES + MDCT_GRANULE_DELAY;
+        granules++;
+        if (center / FRAME_SIZE != frame) {
+            note_detector_emit(&det, mdct_frame_note(sum, summed, det.sample_rate), frame * FRAME_SIZE);
+            memset(sum, 0, sizeof(sum));
+            summed = 0;
+            frame = center / FRAME_SIZE;
+        }
+        for (int i = 0; i < MDCT_GRANULE_LINES; i++) sum[i] += power[i];
+        summed++;
+    }
+    // The FFT analyzer skips a last frame that the song does not fill
+    if (summed && (frame + 1) * FRAME_SIZE < granules * MDCT_GRANULE_LINES) {
+        note_detector_emit(&det, mdct_frame_note(sum, summed, det.sample_rate), frame * FRAME_SIZE);
+    }
+
+    note_detector_close(&det, output_filename);
+    mdct_reader_close(reader);
+    if (status < 0) {
+        printf("Erro: o analisador MDCT so le MP3 Layer III ('%s').\n", mp3_filename);
+        return -1;
+    }
+    return 0;
+}
+
+// The streaming decoder keeps at least this much MP3 data ahead of the read position so
+// minimp3's sync search (up to 10 frames ahead) sees the same bytes as with the whole file
+#define STREAM_MP3_BUFFER_SIZE (64 * 1024)
+#define STREAM_MP3_LOOKAHEAD (32 * 1024)
+
+int analyze_mp3_stream(const char* mp3_filename, const char* output_filename,
+                       const AnalysisOptions* options, const NoteSink* sink) {
+    FILE* f = fopen(mp3_filename, "rb");
+    if (!f) {
+        printf("Erro ao abrir o arquivo '%s'!\n", mp3_filename);
+        return -1;
+    }
+
+    unsigned char* mp3_buffer = (unsigned char*)malloc(STREAM_MP3_BUFFER_SIZE);
+    // One analysis window plus one decoded MP3 frame spilling past it
+    short* window = (short*)malloc((FRAME_SIZE * 2 + MINIMP3_MAX_SAMPLES_PER_FRAME) * sizeof(short));
+    if (!mp3_buffer || !window) {
+        printf("Erro ao alocar memoria para a analise em streaming.\n");
+        free(mp3_buffer);
+        free(window);
+        fclose(f);
+        return -1;
+    }
+
+    NoteDetector det;
+    if (note_detector_open(&det, output_filename, NULL, options) != 0) {
+        free(mp3_buffer);
+        free(window);
+        fclose(f);
+        return -1;
+    }
+    det.sink = sink;
+    if (sink) det.verbose = 0;
+
+    mp3dec_t dec;
+    mp3dec_init(&dec);
+    mp3dec_frame_info_t info;
+
+    size_t mp3_fill = 0, mp3_pos = 0;
+    int eof = 0;
+    size_t window_fill = 0;
+    long window_offset = 0;
+    long window_end = LONG_MAX;
+    size_t discard = 0;   // decoded samples before the first window
+    int stopped = 0;
+
+    if (options && (options->start_seconds > 0 || options->end_seconds > 0)) {
+        // Starts reading at the range's first frame, with the decoder primed from the index
+        Mp3Source source;
+        long k = 0;
+        int primed = mp3_source_open(&source, mp3_filename) == 0;
+        if (primed) {
+            k = mp3_index_frame_at(source.index, range_lead_start(options));
+            primed = mp3_index_prime(&source, &dec, k, window) == 0;
+        }
+        if (!primed) {
+            printf("Erro ao posicionar a analise de '%s' no trecho pedido.\n", mp3_filename);
+            mp3_source_close(&source);
+            det.verbose = 0;
+            note_detector_close(&det, output_filename);
+            free(mp3_buffer);
+            free(window);
+            fclose(f);
+            return -1;
+        }
+        const Mp3FrameEntry* frame = &source.index->frames[k];
+        det.emit_from = range_first_window(options, (long)frame->pcm_offset, frame->hz, frame->channels,
+                                           det.hop_size);
+        window_offset = range_lead_window(det.emit_from, (long)frame->pcm_offset, frame->hz, frame->channels,
+                                          det.hop_size);
+        window_end = range_end(options, frame->hz, frame->channels);
+        discard = window_offset - frame->pcm_offset;
+        fseek(f, frame->mp3_offset, SEEK_SET);
+        mp3_source_close(&source);
+    }
+
+    for (;;) {
+        if (!eof && mp3_fill - mp3_pos < STREAM_MP3_LOOKAHEAD) {
+            memmove(mp3_buffer, mp3_buffer + mp3_pos, mp3_fill - mp3_pos);
+            mp3_fill -= mp3_pos;
+            mp3_pos = 0;
+            size_t wanted = STREAM_MP3_BUFFER_SIZE - mp3_fill;
+            size_t got = fread(mp3_buffer + mp3_fill, 1, wanted, f);
+            mp3_fill += got;
+            eof = got < wanted;
+        }
+
+        int available = (int)(mp3_fill - mp3_pos);
+        int samples = mp3dec_decode_frame(&dec, mp3_buffer + mp3_pos, available,
+                                          window + window_fill, &info);
+        if (samples <= 0) {
+            // No frame in the buffered bytes (e.g. a large ID3 tag): drop the part the
+            // sync search fully covered and keep looking, like a search over the whole file
+            if (!eof && info.frame_bytes == available) {
+                mp3_pos += available - STREAM_MP3_LOOKAHEAD;
+                continue;
             }
-            in[i].i = 0;
-        }
-        kiss_fft(cfg, in, out);
-
-        float max_mag = 0;
-        int max_idx = 0;
-        for (int i = 1; i < FRAME_SIZE / 2; i++) {
-            float mag = sqrt(out[i].r * out[i].r + out[i].i * out[i].i);
-            if (mag > max_mag) { max_mag = mag; max_idx = i; }
-        }
-        float freq = (float)max_idx * audio_data->sample_rate / FRAME_SIZE;
-        
-        if (max_mag > THRESHOLD) {
-            const char* note = freq_to_note(freq);
-            if (note) {
-                if (strcmp(note, ultima_nota_encontrada) != 0) {
-                    double time = (double)pcm_offset / (audio_data->channels * audio_data->sample_rate);
-                    fprintf(output, "%.2f\t%s\n", time, note);
-                    strcpy(ultima_nota_encontrada, note);
-                }
+            break;
+        }
+        mp3_pos += info.frame_bytes;
+
+        if (!det.channels) {
+            note_detector_start(&det, info.hz, info.channels);
+        }
+        window_fill += samples * info.channels;
+        if (discard > 0) {
+            size_t dropped = discard < window_fill ? discard : window_fill;
+            window_fill -= dropped;
+            discard -= dropped;
+            memmove(window, window + dropped, window_fill * sizeof(short));
+        }
+
+        // A window is only analyzed once a sample past its end exists, same as the in-memory loop
+        size_t window_size = FRAME_SIZE * det.channels;
+        size_t frame_step = det.hop_size * det.channels;
+        while (window_fill > window_size && window_offset < window_end) {
+            note_detector_process(&det, window, window_offset);
+            window_fill -= frame_step;
+            window_offset += frame_step;
+            memmove(window, window + frame_step, window_fill * sizeof(short));
+            // Every note stamped before the next window's start has been delivered
+            if (sink && sink->on_progress &&
+                sink->on_progress(sink->user, (double)window_offset / (det.channels * det.sample_rate))) {
+                stopped = 1;
+                break;
             }
         }
+        if (stopped || window_offset >= window_end) break;
+    }
+
+    note_detector_close(&det, output_filename);
+    free(mp3_buffer);
+    free(window);
+    fclose(f);
+    return stopped;
+}
+
+int analyze_mp3_to_file(const char* mp3_filename, const char* output_filename, const AnalysisOptions* options) {
+    if (options->engine == ANALYSIS_ENGINE_MDCT) {
+        printf("Analisando as linhas MDCT do MP3, sem sintetizar o PCM...\n");
+        int result = analyze_mdct_to_file(mp3_filename, output_filename, options);
+        if (result == 0) printf("Notas salvas em '%s'!\n", output_filename);
+        return result;
     }
 
-    kiss_fft_free(cfg);
-    fclose(output);
-    printf("Notas salvas em '%s'!\n", output_filename);
+    if (options->mode == ANALYSIS_STREAMING) {
+        return analyze_mp3_stream(mp3_filename, output_filename, options, NULL);
+    }
+
+    if ((options->start_seconds > 0 || options->end_seconds > 0) && !options->decimate && !options->float_decode) {
+        return analyze_mp3_range(mp3_filename, output_filename, options);
+    }
+
+    if (options->float_decode && !options->decimate) {
+        DecimatedAudio* mono = load_mp3_mono_float(mp3_filename);
+        if (!mono) return -1;
+        printf("Analisando áudio decodificado em float com taxa de amostragem de %d Hz...\n", mono->source_rate);
+        int result = analyze_decimated_to_file(mono, output_filename, options);
+        if (result == 0) printf("Notas salvas em '%s'!\n", output_filename);
+        free_decimated_audio(mono);
+        return result;
+    }
+
+    // The FFT threads share the decode as well
+    AudioData* audio_data = options->num_threads > 1 ? load_mp3_file_parallel(mp3_filename, options->num_threads)
+                                                     : load_mp3_file(mp3_filename);
+    if (!audio_data) return -1;
+    if (options->decimate) {
+        // Only the low-band copy stays in memory during the analysis
+        DecimatedAudio* low_band = decimate_pcm(audio_data->pcm_buffer, audio_data->pcm_size, audio_data->channels,
+                                                audio_data->sample_rate, decimation_factor_for_rate(audio_data->sample_rate));
+        free_audio_data(audio_data);
+        if (!low_band) return -1;
+        printf("Analisando copia decimada: %d Hz -> %d Hz, FFT de %d pontos...\n", low_band->source_rate,
+               low_band->source_rate / low_band->factor, FRAME_SIZE / low_band->factor);
+        int result = analyze_decimated_to_file(low_band, output_filename, options);
+        if (result == 0) printf("Notas salvas em '%s'!\n", output_filename);
+        free_decimated_audio(low_band);
+        return result;
+    }
+    int result = analyze_audio_with_options(audio_data, output_filename, options);
+    free_audio_data(audio_data);
+    return result;
 }
\ No newline at end of file
@@ -4,10 +4,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include "janela.h"
+#include "decimacao.h"
+#include "decodificacao_float.h"
 
 #define FRAME_SIZE 4096
 #define THRESHOLD 10.0
 #define NUM_NOTES 48
+#define NOTE_DETECTOR_VERSION 2   // bump when a change alters the charts made with the same options
+#define NOTE_NONE -1     // no note in a frame; notes are otherwise indices into the C2..B5 scale
 
 typedef struct {
     short* pcm_buffer;
@@ -16,9 +21,86 @@ typedef struct {
     int channels;
 } AudioData;
 
+typedef enum {
+    ANALYSIS_IN_MEMORY,  // decode the whole song into AudioData, then analyze
+    ANALYSIS_STREAMING   // decode and analyze frame by frame with bounded memory
+} AnalysisMode;
+
+typedef enum {
+    ANALYSIS_ENGINE_FFT,        // kiss_fft over the decoded PCM
+    ANALYSIS_ENGINE_MDCT,       // experimental: the MP3's own MDCT lines, no PCM synthesis (serial)
+    ANALYSIS_ENGINE_GOERTZEL,   // only the note bins, a Goertzel bank per window (banco_notas.h, serial)
+    ANALYSIS_ENGINE_SDFT        // only the note bins, a sliding DFT updated by each hop (serial)
+} AnalysisEngine;
+
+typedef struct {
+    AnalysisMode mode;
+    int num_threads;     // FFT worker threads for ANALYSIS_IN_MEMORY (1 = serial)
+    WindowType window;   // STFT window applied to each FRAME_SIZE frame
+    int hop_size;        // samples between frame starts, 1..FRAME_SIZE (FRAME_SIZE = no overlap)
+    int decimate;        // ANALYSIS_IN_MEMORY only: analyze a decimated mono copy (serial)
+    int float_decode;    // ANALYSIS_IN_MEMORY without decimate: decode to mono float (serial)
+    AnalysisEngine engine;   // ANALYSIS_ENGINE_MDCT ignores every other option; GOERTZEL and SDFT
+                             // replace the FFT on int16 PCM (not with decimate/float_decode)
+    // Only chart the windows that start in [start_seconds, end_seconds) (end 0 = to the end of
+    // the song), decoding just the frames they need through the song's index (indice_mp3.h).
+    // Notes keep their time in the song and are the full chart's lines in the range (a short
+    // lead-in before it is analyzed too, so a note sounding across the start is not repeated).
+    // FFT on int16 PCM only: not with decimate/float_decode.
+    double start_seconds;
+    double end_seconds;
+} AnalysisOptions;
+
+#define ANALYSIS_OPTIONS_DEFAULT { ANALYSIS_IN_MEMORY, 1, WINDOW_RECTANGULAR, FRAME_SIZE, 0, 0, ANALYSIS_ENGINE_FFT, 0, 0 }
+
+// Receives the chart while it is being made, for callers that use it before the analysis ends.
+// on_note gets each note written to the chart (time in seconds, index into the C2..B5 scale);
+// on_progress gets the time up to which every note has been delivered, once per window, and
+// returns non-zero to stop the analysis there. Either may be NULL. Both run on the analyzing
+// thread.
+typedef struct {
+    void (*on_note)(void* user, double time, int note);
+    int (*on_progress)(void* user, double analyzed_seconds);
+    void* user;
+} NoteSink;
+
+// Analysis context for many songs on one thread: the FFT plan, the STFT settings, the note
+// bank (rebuilt only when the sample rate or channel count changes) and the PCM and chart
+// buffers, which grow to the largest song so far and are kept. After the first songs,
+// analyze_mp3_with_plan makes no heap allocation. Plans share no state, so threads
+// can each use their own; a single plan is not thread-safe.
+typedef struct AnalysisPlan AnalysisPlan;
+
+typedef struct {
+    long songs;              // charts written by analyze_mp3_with_plan
+    long allocations;        // heap allocations made by the plan, its creation included
+    size_t reserved_bytes;   // memory the plan holds: context, FFT plan, note bank and buffers
+    double audio_seconds;    // length of the last song
+} AnalysisPlanStats;
+
 // Function prototypes
 AudioData* load_mp3_file(const char* filename);
+size_t estimate_pcm_samples(const unsigned char* mp3, long mp3_size);   // interleaved upper bound
+size_t count_pcm_samples(const unsigned char* mp3, long mp3_size);      // same, never trusting a VBR tag
 void free_audio_data(AudioData* audio_data);
 void analyze_audio_to_file(AudioData* audio_data, const char* output_filename);
+void analyze_audio_to_file_parallel(AudioData* audio_data, const char* output_filename, int num_threads);
+int analyze_audio_with_options(AudioData* audio_data, const char* output_filename, const AnalysisOptions* options);
+// Same detector on a decimate_pcm() copy, with a FRAME_SIZE / factor FFT of the same resolution (quiet)
+int analyze_decimated_to_file(const DecimatedAudio* audio, const char* output_filename, const AnalysisOptions* options);
+// Notes from the MDCT lines of a Layer III file (analise_mdct.h) on the FFT's frame grid (quiet)
+int analyze_mdct_to_file(const char* mp3_filename, const char* output_filename, const AnalysisOptions* options);
+int analyze_mp3_to_file(const char* mp3_filename, const char* output_filename, const AnalysisOptions* options);
+// Streaming analysis that also feeds sink (may be NULL); output_filename may be NULL to skip the file.
+// Returns 1 when sink's on_progress stopped it (the file then holds the chart so far)
+int analyze_mp3_stream(const char* mp3_filename, const char* output_filename,
+                       const AnalysisOptions* options, const NoteSink* sink);
+void build_bin_note_table(signed char* bin_notes, int sample_rate);   // FRAME_SIZE / 2 entries
+AnalysisPlan* analysis_plan_alloc(const AnalysisOptions* options);
+void analysis_plan_free(AnalysisPlan* plan);
+int analyze_audio_with_plan(AudioData* audio_data, const char* output_filename, AnalysisPlan* plan);
+// MP3 to chart in the plan's buffers (mmapped song, window and hop from the plan; quiet)
+int analyze_mp3_with_plan(AnalysisPlan* plan, const char* mp3_filename, const char* output_filename);
+void analysis_plan_stats(const AnalysisPlan* plan, AnalysisPlanStats* stats);
 
 #endif // AUDIO_ANALYSIS_H
\ No newline at end of file
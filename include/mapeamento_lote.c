@@ -0,0 +1,302 @@
+#include "mapeamento_lote.h"
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#define BATCH_CHART_SUFFIX ".notes.txt"
+
+typedef struct {
+    char* mp3_path;
+    char* chart_path;
+    long file_size;
+    int ok;
+    int worker;
+    double audio_seconds;
+    double elapsed_seconds;
+} BatchSong;
+
+// One deque per worker: the owner pops from the bottom, idle workers steal from the top
+typedef struct {
+    pthread_mutex_t lock;
+    int* jobs;
+    int top;
+    int bottom;
+} JobDeque;
+
+typedef struct {
+    BatchSong* songs;
+    JobDeque* deques;
+    int num_workers;
+    const AnalysisOptions* options;
+} BatchPool;
+
+typedef struct {
+    BatchPool* pool;
+    int id;
+    AnalysisPlanStats stats;   // summed over the plans the worker used
+} BatchWorker;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int deque_pop(JobDeque* d) {
+    int job = -1;
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top) job = d->jobs[--d->bottom];
+    pthread_mutex_unlock(&d->lock);
+    return job;
+}
+
+static int deque_steal(JobDeque* d) {
+    int job = -1;
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top) job = d->jobs[d->top++];
+    pthread_mutex_unlock(&d->lock);
+    return job;
+}
+
+static int has_mp3_extension(const char* name) {
+    size_t len = strlen(name);
+    return len > 4 && strcasecmp(name + len - 4, ".mp3") == 0;
+}
+
+static int add_song(BatchSong** songs, int* count, int* capacity, const char* path) {
+    if (*count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 16;
+        BatchSong* grown = (BatchSong*)realloc(*songs, new_capacity * sizeof(BatchSong));
+        if (!grown) return -1;
+        *songs = grown;
+        *capacity = new_capacity;
+    }
+
+    BatchSong* song = &(*songs)[*count];
+    memset(song, 0, sizeof(BatchSong));
+    song->mp3_path = strdup(path);
+
+    // musica.mp3 -> musica.notes.txt
+    size_t base_len = strlen(path);
+    if (has_mp3_extension(path)) base_len -= 4;
+    song->chart_path = (char*)malloc(base_len + sizeof(BATCH_CHART_SUFFIX));
+    if (!song->mp3_path || !song->chart_path) {
+        free(song->mp3_path);
+        free(song->chart_path);
+        return -1;
+    }
+    memcpy(song->chart_path, path, base_len);
+    strcpy(song->chart_path + base_len, BATCH_CHART_SUFFIX);
+
+    struct stat st;
+    song->file_size = stat(path, &st) == 0 ? (long)st.st_size : 0;
+    (*count)++;
+    return 0;
+}
+
+static int compare_song_path(const void* a, const void* b) {
+    return strcmp(((const BatchSong*)a)->mp3_path, ((const BatchSong*)b)->mp3_path);
+}
+
+// Reads the song list from a directory (every .mp3 in it) or from a list file.
+// *count is -1 when the input cannot be opened at all.
+static BatchSong* collect_songs(const char* input, int* count) {
+    BatchSong* songs = NULL;
+    int capacity = 0;
+    *count = 0;
+
+    DIR* dir = opendir(input);
+    if (dir) {
+        struct dirent* entry;
+        char path[4096];
+        while ((entry = readdir(dir)) != NULL) {
+            if (!has_mp3_extension(entry->d_name)) continue;
+            snprintf(path, sizeof(path), "%s/%s", input, entry->d_name);
+            if (add_song(&songs, count, &capacity, path) != 0) break;
+        }
+        closedir(dir);
+        qsort(songs, *count, sizeof(BatchSong), compare_song_path);
+        return songs;
+    }
+
+    FILE* list = fopen(input, "r");
+    if (!list) {
+        printf("Erro ao abrir a lista de musicas '%s'!\n", input);
+        *count = -1;
+        return NULL;
+    }
+    char line[4096];
+    while (fgets(line, sizeof(line), list)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+        if (add_song(&songs, count, &capacity, line) != 0) break;
+    }
+    fclose(list);
+    return songs;
+}
+
+static void run_song(BatchSong* song, AnalysisPlan* plan) {
+    double start = now_seconds();
+    song->ok = analyze_mp3_with_plan(plan, song->mp3_path, song->chart_path) == 0;
+    AnalysisPlanStats stats;
+    analysis_plan_stats(plan, &stats);
+    song->audio_seconds = stats.audio_seconds;
+    song->elapsed_seconds = now_seconds() - start;
+}
+
+static void* batch_worker(void* arg) {
+    BatchWorker* worker = (BatchWorker*)arg;
+    BatchPool* pool = worker->pool;
+    // The plan (FFT plan and PCM/chart buffers) is built once per worker and reused for every
+    // song it picks up; once its buffers fit the largest song, songs cost no heap allocation
+    AnalysisPlan* plan = analysis_plan_alloc(pool->options);
+    if (!plan) return NULL;
+
+    for (;;) {
+        int job = deque_pop(&pool->deques[worker->id]);
+        for (int k = 1; job < 0 && k < pool->num_workers; k++) {
+            job = deque_steal(&pool->deques[(worker->id + k) % pool->num_workers]);
+        }
+        // Jobs never spawn new jobs, so all deques empty means the batch is done
+        if (job < 0) break;
+        pool->songs[job].worker = worker->id;
+        run_song(&pool->songs[job], plan);
+    }
+
+    AnalysisPlanStats stats;
+    analysis_plan_stats(plan, &stats);
+    worker->stats.songs += stats.songs;
+    worker->stats.allocations += stats.allocations;
+    if (stats.reserved_bytes > worker->stats.reserved_bytes) worker->stats.reserved_bytes = stats.reserved_bytes;
+    analysis_plan_free(plan);
+    return NULL;
+}
+
+static void free_songs(BatchSong* songs, int count) {
+    for (int i = 0; i < count; i++) {
+        free(songs[i].mp3_path);
+        free(songs[i].chart_path);
+    }
+    free(songs);
+}
+
+typedef struct {
+    long file_size;
+    int song;
+} JobOrder;
+
+static int compare_job_size(const void* a, const void* b) {
+    long sa = ((const JobOrder*)a)->file_size;
+    long sb = ((const JobOrder*)b)->file_size;
+    return (sa < sb) - (sa > sb);
+}
+
+int analyze_mp3_batch(const char* input, const AnalysisOptions* options) {
+    int num_songs = 0;
+    BatchSong* songs = collect_songs(input, &num_songs);
+    if (num_songs < 0) return -1;
+    if (num_songs == 0) {
+        printf("Nenhuma musica encontrada em '%s'.\n", input);
+        free(songs);
+        return 0;
+    }
+    int num_threads = options->num_threads;
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > num_songs) num_threads = num_songs;
+
+    JobOrder* order = (JobOrder*)malloc(num_songs * sizeof(JobOrder));
+    JobDeque* deques = (JobDeque*)calloc(num_threads, sizeof(JobDeque));
+    pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+    BatchWorker* workers = (BatchWorker*)malloc(num_threads * sizeof(BatchWorker));
+    int out_of_memory = !order || !deques || !threads || !workers;
+    for (int t = 0; !out_of_memory && t < num_threads; t++) {
+        deques[t].jobs = (int*)malloc((num_songs / num_threads + 1) * sizeof(int));
+        out_of_memory = !deques[t].jobs;
+    }
+    if (out_of_memory) {
+        printf("Erro ao alocar memoria para o processamento em lote.\n");
+        for (int t = 0; deques && t < num_threads; t++) free(deques[t].jobs);
+        free_songs(songs, num_songs);
+        free(order);
+        free(deques);
+        free(threads);
+        free(workers);
+        return -1;
+    }
+
+    // Largest songs first, dealt round-robin; the owner pops from the bottom of its
+    // deque so each worker starts on its biggest song and thieves take the smallest
+    for (int i = 0; i < num_songs; i++) {
+        order[i].file_size = songs[i].file_size;
+        order[i].song = i;
+    }
+    qsort(order, num_songs, sizeof(JobOrder), compare_job_size);
+    for (int t = 0; t < num_threads; t++) pthread_mutex_init(&deques[t].lock, NULL);
+    for (int i = num_songs - 1; i >= 0; i--) {
+        JobDeque* d = &deques[i % num_threads];
+        d->jobs[d->bottom++] = order[i].song;
+    }
+
+    printf("Mapeando %d musicas com %d threads...\n", num_songs, num_threads);
+    BatchPool pool = { songs, deques, num_threads, options };
+    double start = now_seconds();
+    int not_started = -1;
+    for (int t = 0; t < num_threads; t++) {
+        memset(&workers[t], 0, sizeof(BatchWorker));
+        workers[t].pool = &pool;
+        workers[t].id = t;
+        if (pthread_create(&threads[t], NULL, batch_worker, &workers[t]) != 0) {
+            workers[t].pool = NULL;
+            if (not_started < 0) not_started = t;
+        }
+    }
+    for (int t = 0; t < num_threads; t++) {
+        if (workers[t].pool) pthread_join(threads[t], NULL);
+    }
+    // Songs left in the deques of workers that could not start are charted on this thread
+    if (not_started >= 0) {
+        workers[not_started].pool = &pool;
+        batch_worker(&workers[not_started]);
+    }
+    double wall = now_seconds() - start;
+
+    int failed = 0;
+    double total_audio = 0;
+    for (int i = 0; i < num_songs; i++) {
+        BatchSong* song = &songs[i];
+        if (song->ok) {
+            printf("  [t%d] %-40s %7.1f s de audio em %6.2f s (%6.1fx)\n", song->worker, song->mp3_path,
+                   song->audio_seconds, song->elapsed_seconds,
+                   song->elapsed_seconds > 0 ? song->audio_seconds / song->elapsed_seconds : 0.0);
+            total_audio += song->audio_seconds;
+        } else {
+            printf("  [falha] %s\n", song->mp3_path);
+            failed++;
+        }
+    }
+    printf("%d musicas (%d falhas) em %.2f s: %.1f musicas/min, %.1f s de audio/s\n",
+           num_songs, failed, wall, wall > 0 ? num_songs * 60.0 / wall : 0.0,
+           wall > 0 ? total_audio / wall : 0.0);
+    long allocations = 0;
+    size_t reserved = 0;
+    for (int t = 0; t < num_threads; t++) {
+        allocations += workers[t].stats.allocations;
+        if (workers[t].stats.reserved_bytes > reserved) reserved = workers[t].stats.reserved_bytes;
+    }
+    printf("Analisador: %ld alocacoes no heap para %d musicas, ate %.1f MB por thread\n",
+           allocations, num_songs, reserved / (1024.0 * 1024.0));
+
+    for (int t = 0; t < num_threads; t++) {
+        pthread_mutex_destroy(&deques[t].lock);
+        free(deques[t].jobs);
+    }
+    free_songs(songs, num_songs);
+    free(order);
+    free(deques);
+    free(threads);
+    free(workers);
+    return failed;
+}
@@ -0,0 +1,13 @@
+#ifndef MAPEAMENTO_LOTE_H
+#define MAPEAMENTO_LOTE_H
+
+#include "mapeamento_audio.h"
+
+// Charts every song listed in `input` (a directory of .mp3 files or a text file with
+// one path per line) on a work-stealing pool of options->num_threads workers, each song
+// with options' window and hop. Each chart is written next to its song as
+// <nome>.notes.txt. Returns the number of failed songs, or -1 if the input cannot be read
+// or the pool cannot be allocated.
+int analyze_mp3_batch(const char* input, const AnalysisOptions* options);
+
+#endif // MAPEAMENTO_LOTE_H
@@ -0,0 +1,333 @@
+#include "notas_nivel.h"
+#include "mapa_compilado.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+int level_notes_alloc(LevelNotes* notes, int capacity) {
+    if (capacity < 0) return -1;
+    size_t words = ((size_t)capacity + 63) / 64;
+    // Bitsets first: the 8-byte words need the block's alignment, the lanes need none
+    char* block = (char*)calloc(1, 2 * words * sizeof(uint64_t) + (size_t)capacity * (sizeof(float) + 1) + 1);
+    if (!block) return -1;
+    notes->processed = (uint64_t*)block;
+    notes->pressed = notes->processed + words;
+    notes->timestamps = (float*)(notes->pressed + words);
+    notes->lanes = (uint8_t*)(notes->timestamps + capacity);
+    notes->capacity = capacity;
+    return 0;
+}
+
+void level_notes_free(LevelNotes* notes) {
+    free(notes->processed);
+    notes->processed = NULL;
+    notes->pressed = NULL;
+    notes->timestamps = NULL;
+    notes->lanes = NULL;
+    notes->capacity = 0;
+}
+
+// The lane carregar_nivel has always given a note name: C/D -> 0, E/F -> 1, G/A -> 2, B -> 3
+static int lane_for_name(const char* name) {
+    switch (name[0]) {
+        case 'C': case 'D': return 0;
+        case 'E': case 'F': return 1;
+        case 'G': case 'A': return 2;
+        case 'B': return 3;
+    }
+    return -1;
+}
+
+// Chart errors printed before the rest are only counted: one bad paste can be a million lines
+#define MAX_REPORTED_LINES 10
+
+static int is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Powers of ten that are exact in a double: with a mantissa below 2^53, one correctly
+// rounded multiply or divide gives the double nearest the decimal
+static const double POW10_EXACT[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Seconds at p..end: [sign] digits [. digits] [e [sign] digits], which covers the
+// analyzer's "%.2f" and hand edits, read without the locale. Rounding that double to float
+// gives strtof's result unless it landed exactly halfway between two floats; that case, and
+// anything outside the fast path, goes through strtof. Returns the end of the number, NULL
+// if there is none.
+static const char* parse_seconds(const char* p, const char* end, float* value) {
+    const char* start = p;
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    uint64_t mantissa = 0;   // the first 19 significant digits; value = mantissa * 10^exponent
+    int significant = 0, exponent = 0, digits = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+        if (significant < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            significant += mantissa != 0;
+        } else {
+            exponent++;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                significant += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+    if (digits == 0) return NULL;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        int exp_negative = 0, exp_value = 0;
+        const char* q = p + 1;
+        if (q < end && (*q == '-' || *q == '+')) exp_negative = *q++ == '-';
+        if (q == end || *q < '0' || *q > '9') return NULL;
+        for (; q < end && *q >= '0' && *q <= '9'; q++) {
+            if (exp_value < 10000) exp_value = exp_value * 10 + (*q - '0');
+        }
+        exponent += exp_negative ? -exp_value : exp_value;
+        p = q;
+    }
+
+    if (mantissa < (1ull << 53) && exponent >= -22 && exponent <= 22) {
+        double d = (double)mantissa;
+        d = exponent < 0 ? d / POW10_EXACT[-exponent] : d * POW10_EXACT[exponent];
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof(bits));
+        if ((bits & 0x1FFFFFFF) != 0x10000000) {
+            *value = (float)(negative ? -d : d);
+            return p;
+        }
+    }
+    char buffer[64];
+    size_t length = (size_t)(p - start);
+    if (length >= sizeof(buffer)) return NULL;
+    memcpy(buffer, start, length);
+    buffer[length] = '\0';
+    *value = strtof(buffer, NULL);
+    return p;
+}
+
+// The line starting at *line, in one scan up to its newline; *line moves past it. Returns 1
+// for a note, 0 for a blank line or a name with no lane (skipped, as always), -1 if the
+// line isn't "<seconds> <note name>".
+static int parse_line(const char** line, const char* end, float* timestamp, int* lane) {
+    const char* p = *line;
+    int result = -1;
+    while (p < end && is_blank(*p)) p++;
+    if (p == end || *p == '\n') {
+        result = 0;
+    } else if ((p = parse_seconds(p, end, timestamp)) != NULL && p < end && is_blank(*p)) {
+        while (p < end && is_blank(*p)) p++;
+        const char* name = p;
+        while (p < end && *p != '\n' && !is_blank(*p)) p++;
+        if (p > name) {
+            while (p < end && is_blank(*p)) p++;
+            if (p == end || *p == '\n') {
+                *lane = lane_for_name(name);
+                result = *lane >= 0;
+            }
+        }
+    }
+    if (result < 0 || !p) {
+        p = (const char*)memchr(*line, '\n', end - *line);
+        if (!p) p = end;
+    }
+    *line = p < end ? p + 1 : end;
+    return result;
+}
+
+int level_notes_load_text(LevelNotes* notes, const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    const char* data = NULL;
+    if (st.st_size > 0) {
+        data = (const char*)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == (const char*)MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+    }
+    close(fd);
+    const char* end = data ? data + st.st_size : NULL;
+
+    // One note per line at most: size the arrays by the line count and parse once, straight
+    // into them. Skipped and bad lines leave a few slots unused.
+    int lines = data && end[-1] != '\n';
+    for (const char* p = data; p < end; p++) lines += *p == '\n';
+
+    level_notes_free(notes);
+    if (level_notes_alloc(notes, lines) != 0) {
+        if (data) munmap((void*)data, st.st_size);
+        return -1;
+    }
+
+    int n = 0, bad = 0, line_number = 0;
+    for (const char* p = data; p < end;) {
+        const char* line = p;
+        line_number++;
+
+        float timestamp;
+        int lane;
+        int result = parse_line(&p, end, &timestamp, &lane);
+        if (result > 0) {
+            notes->timestamps[n] = timestamp;
+            notes->lanes[n] = (uint8_t)lane;
+            n++;
+        } else if (result < 0 && ++bad <= MAX_REPORTED_LINES) {
+            int length = (int)(p - line) - (p[-1] == '\n');
+            if (length > 0 && line[length - 1] == '\r') length--;
+            printf("%s:%d: linha invalida, esperado \"<segundos> <nota>\": %.*s\n", filename, line_number,
+                   length > 40 ? 40 : length, line);
+        }
+    }
+    if (bad > MAX_REPORTED_LINES) printf("%s: mais %d linhas invalidas ignoradas\n", filename, bad - MAX_REPORTED_LINES);
+
+    if (data) munmap((void*)data, st.st_size);
+    // A hand-edited notes.txt may be out of order
+    if (chart_sort_by_time(notes->timestamps, notes->lanes, (uint32_t)n) != 0) {
+        level_notes_free(notes);
+        return -1;
+    }
+    return n;
+}
+
+int level_notes_load_compiled(LevelNotes* notes, const char* filename) {
+    CompiledChart chart;
+    if (chart_map_compiled(filename, &chart) != 0) return -1;
+
+    level_notes_free(notes);
+    int count = (int)chart.note_count;
+    if (level_notes_alloc(notes, count) != 0) {
+        chart_unmap_compiled(&chart);
+        return -1;
+    }
+    // Already sorted, with the lanes criador_mapa worked out
+    memcpy(notes->timestamps, chart.timestamps, count * sizeof(float));
+    memcpy(notes->lanes, chart.lanes, count);
+    chart_unmap_compiled(&chart);
+    return count;
+}
+
+// One note at a time, for the scalar kernel and the unaligned head and tail of the others.
+// Returns 0 when note i is still open.
+static int expire_note(LevelNotes* notes, int i, double t, double window, int* misses) {
+    if (!(t > notes->timestamps[i] + window)) return 0;
+    if (!level_note_bit(notes->processed, i)) {
+        level_note_set(notes->processed, i);
+        (*misses)++;
+    }
+    return 1;
+}
+
+int level_notes_expire_scalar(LevelNotes* notes, int first, int count, double t, double window, int* misses) {
+    *misses = 0;
+    int i = first;
+    while (i < count && expire_note(notes, i, t, window, misses)) i++;
+    return i;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Takes 8 notes' expired mask (bit l = note i + l, a prefix since the notes are sorted) into
+// the processed byte of notes i..i+7. Returns how many expired; fewer than 8 ends the scan.
+static inline int expire_group(LevelNotes* notes, int i, int expired, int* misses) {
+    uint8_t* processed = (uint8_t*)notes->processed + (i >> 3);
+    *misses += __builtin_popcount(expired & ~*processed & 0xFF);
+    *processed |= (uint8_t)expired;
+    return __builtin_popcount(expired);
+}
+
+__attribute__((target("sse2")))
+int level_notes_expire_sse2(LevelNotes* notes, int first, int count, double t, double window, int* misses) {
+    *misses = 0;
+    int i = first;
+    // Up to a byte boundary of the bitsets one by one, then whole groups of 8 inside count.
+    // Most frames expire nothing: that is one compare, not a group
+    while (i < count && (i & 7) && expire_note(notes, i, t, window, misses)) i++;
+    if ((i & 7) || i == count || !(t > notes->timestamps[i] + window)) return i;
+
+    // Widened to double so the sum rounds exactly as in the scalar test
+    const __m128d vt = _mm_set1_pd(t), vwindow = _mm_set1_pd(window);
+    for (; i + 8 <= count; i += 8) {
+        int expired = 0;
+        for (int k = 0; k < 8; k += 4) {
+            __m128 ts = _mm_loadu_ps(notes->timestamps + i + k);
+            __m128d lo = _mm_add_pd(_mm_cvtps_pd(ts), vwindow);
+            __m128d hi = _mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(ts, ts)), vwindow);
+            expired |= (_mm_movemask_pd(_mm_cmplt_pd(lo, vt)) | (_mm_movemask_pd(_mm_cmplt_pd(hi, vt)) << 2)) << k;
+        }
+        int n = expire_group(notes, i, expired, misses);
+        if (n < 8) return i + n;
+    }
+    while (i < count && expire_note(notes, i, t, window, misses)) i++;
+    return i;
+}
+
+__attribute__((target("avx")))
+int level_notes_expire_avx(LevelNotes* notes, int first, int count, double t, double window, int* misses) {
+    *misses = 0;
+    int i = first;
+    while (i < count && (i & 7) && expire_note(notes, i, t, window, misses)) i++;
+    if ((i & 7) || i == count || !(t > notes->timestamps[i] + window)) return i;
+
+    const __m256d vt = _mm256_set1_pd(t), vwindow = _mm256_set1_pd(window);
+    for (; i + 8 <= count; i += 8) {
+        __m256d lo = _mm256_add_pd(_mm256_cvtps_pd(_mm_loadu_ps(notes->timestamps + i)), vwindow);
+        __m256d hi = _mm256_add_pd(_mm256_cvtps_pd(_mm_loadu_ps(notes->timestamps + i + 4)), vwindow);
+        int expired = _mm256_movemask_pd(_mm256_cmp_pd(lo, vt, _CMP_LT_OQ)) |
+                      (_mm256_movemask_pd(_mm256_cmp_pd(hi, vt, _CMP_LT_OQ)) << 4);
+        int n = expire_group(notes, i, expired, misses);
+        if (n < 8) return i + n;
+    }
+    while (i < count && expire_note(notes, i, t, window, misses)) i++;
+    return i;
+}
+
+#endif
+
+static LevelNotesExpireFn expire_kernel = level_notes_expire_scalar;
+static const char* expire_kernel_name = "scalar";
+static pthread_once_t expire_kernel_once = PTHREAD_ONCE_INIT;
+
+static void select_expire_kernel(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx")) {
+        expire_kernel = level_notes_expire_avx;
+        expire_kernel_name = "avx";
+    } else if (__builtin_cpu_supports("sse2")) {
+        expire_kernel = level_notes_expire_sse2;
+        expire_kernel_name = "sse2";
+    }
+#endif
+}
+
+int level_notes_expire(LevelNotes* notes, int first, int count, double t, double window, int* misses) {
+    pthread_once(&expire_kernel_once, select_expire_kernel);
+    return expire_kernel(notes, first, count, t, window, misses);
+}
+
+const char* level_notes_expire_kernel_name(void) {
+    pthread_once(&expire_kernel_once, select_expire_kernel);
+    return expire_kernel_name;
+}
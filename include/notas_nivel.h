@@ -0,0 +1,56 @@
+#ifndef NOTAS_NIVEL_H
+#define NOTAS_NIVEL_H
+
+#include <stdint.h>
+
+// The game's chart as a structure of arrays, allocated once in a single block of exactly
+// the chart's size. The per-frame loops read dense timestamps and lane bytes and flip
+// bits, about 5.25 bytes per note instead of a 20-byte record with its name. Notes are
+// sorted by timestamp and there is no upper limit on their number.
+typedef struct {
+    uint64_t* processed;   // bit i: note i was judged (hit, or its window closed)
+    uint64_t* pressed;     // bit i: note i was hit
+    float* timestamps;     // seconds
+    uint8_t* lanes;        // 0..3
+    int capacity;
+} LevelNotes;
+
+// capacity notes, every bit clear. Returns -1 if memory runs out. A zeroed LevelNotes has
+// capacity 0 and can be freed.
+int level_notes_alloc(LevelNotes* notes, int capacity);
+void level_notes_free(LevelNotes* notes);
+
+// Replace notes with the chart in a notes.txt or a compiled .ghc (mapa_compilado.h), sorted
+// by time. Return the note count, -1 if the file can't be read or memory runs out.
+// notes.txt is mmapped and parsed in one pass without stdio or the locale: one
+// "<seconds> <note name>" per line, names with no lane skipped, blank lines ignored. Other
+// lines are skipped and printed with their line number; the capacity is the line count.
+int level_notes_load_text(LevelNotes* notes, const char* filename);
+int level_notes_load_compiled(LevelNotes* notes, const char* filename);
+
+typedef int (*LevelNotesExpireFn)(LevelNotes* notes, int first, int count, double t, double window, int* misses);
+
+int level_notes_expire_scalar(LevelNotes* notes, int first, int count, double t, double window, int* misses);
+#if defined(__x86_64__) || defined(__i386__)
+int level_notes_expire_sse2(LevelNotes* notes, int first, int count, double t, double window, int* misses);
+int level_notes_expire_avx(LevelNotes* notes, int first, int count, double t, double window, int* misses);
+#endif
+
+// Best kernel for the running CPU (AVX, SSE2 or scalar), chosen on the first call: the
+// board's Atom gets SSE2
+int level_notes_expire(LevelNotes* notes, int first, int count, double t, double window, int* misses);
+const char* level_notes_expire_kernel_name(void);
+
+static inline int level_note_bit(const uint64_t* bits, int i) {
+    return (int)((bits[i >> 6] >> (i & 63)) & 1);
+}
+
+static inline void level_note_set(uint64_t* bits, int i) {
+    bits[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+static inline void level_note_clear(uint64_t* bits, int i) {
+    bits[i >> 6] &= ~((uint64_t)1 << (i & 63));
+}
+
+#endif // NOTAS_NIVEL_H
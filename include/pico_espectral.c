@@ -0,0 +1,125 @@
+#include "pico_espectral.h"
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+int spectrum_peak_scalar(const kiss_fft_cpx* bins, int first, int end, float* peak_sq) {
+    float max_sq = 0;
+    int max_idx = first;
+    for (int i = first; i < end; i++) {
+        float sq = bins[i].r * bins[i].r + bins[i].i * bins[i].i;
+        if (sq > max_sq) { max_sq = sq; max_idx = i; }
+    }
+    *peak_sq = max_sq;
+    return max_idx;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Merges per-lane maxima: the largest value wins, ties go to the lowest bin
+static int reduce_lanes(const float* lane_max, const int* lane_idx, int lanes, int max_idx, float* max_sq) {
+    for (int l = 0; l < lanes; l++) {
+        if (lane_max[l] > *max_sq || (lane_max[l] == *max_sq && lane_max[l] > 0 && lane_idx[l] < max_idx)) {
+            *max_sq = lane_max[l];
+            max_idx = lane_idx[l];
+        }
+    }
+    return max_idx;
+}
+
+__attribute__((target("sse2")))
+int spectrum_peak_sse2(const kiss_fft_cpx* bins, int first, int end, float* peak_sq) {
+    const float* p = (const float*)(bins + first);
+    int count = (end - first) & ~3;
+    __m128 vmax = _mm_setzero_ps();
+    __m128i vidx = _mm_set1_epi32(first);
+    __m128i idx = _mm_setr_epi32(first, first + 1, first + 2, first + 3);
+    const __m128i step = _mm_set1_epi32(4);
+
+    for (int i = 0; i < count; i += 4) {
+        __m128 a = _mm_loadu_ps(p + 2 * i);       // r0 i0 r1 i1
+        __m128 b = _mm_loadu_ps(p + 2 * i + 4);   // r2 i2 r3 i3
+        __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 sq = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+        __m128 gt = _mm_cmpgt_ps(sq, vmax);
+        vmax = _mm_or_ps(_mm_and_ps(gt, sq), _mm_andnot_ps(gt, vmax));
+        __m128i gti = _mm_castps_si128(gt);
+        vidx = _mm_or_si128(_mm_and_si128(gti, idx), _mm_andnot_si128(gti, vidx));
+        idx = _mm_add_epi32(idx, step);
+    }
+
+    float lane_max[4];
+    int lane_idx[4];
+    _mm_storeu_ps(lane_max, vmax);
+    _mm_storeu_si128((__m128i*)lane_idx, vidx);
+
+    // Tail first, so the lanes only replace it with a larger value or a lower bin
+    int max_idx = spectrum_peak_scalar(bins, first + count, end, peak_sq);
+    if (*peak_sq == 0) max_idx = first;
+    return reduce_lanes(lane_max, lane_idx, 4, max_idx, peak_sq);
+}
+
+__attribute__((target("avx2")))
+int spectrum_peak_avx2(const kiss_fft_cpx* bins, int first, int end, float* peak_sq) {
+    const float* p = (const float*)(bins + first);
+    int count = (end - first) & ~7;
+    __m256 vmax = _mm256_setzero_ps();
+    __m256i vidx = _mm256_set1_epi32(first);
+    // The shuffle below works inside each 128-bit half, so lanes hold bins 0 1 4 5 | 2 3 6 7
+    __m256i idx = _mm256_add_epi32(_mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7), _mm256_set1_epi32(first));
+    const __m256i step = _mm256_set1_epi32(8);
+
+    for (int i = 0; i < count; i += 8) {
+        __m256 a = _mm256_loadu_ps(p + 2 * i);       // bins 0 1 | 2 3
+        __m256 b = _mm256_loadu_ps(p + 2 * i + 8);   // bins 4 5 | 6 7
+        __m256 re = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 im = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        // mul + add rather than FMA, so every bin rounds exactly like the scalar kernel
+        __m256 sq = _mm256_add_ps(_mm256_mul_ps(re, re), _mm256_mul_ps(im, im));
+        __m256 gt = _mm256_cmp_ps(sq, vmax, _CMP_GT_OQ);
+        vmax = _mm256_blendv_ps(vmax, sq, gt);
+        vidx = _mm256_blendv_epi8(vidx, idx, _mm256_castps_si256(gt));
+        idx = _mm256_add_epi32(idx, step);
+    }
+
+    float lane_max[8];
+    int lane_idx[8];
+    _mm256_storeu_ps(lane_max, vmax);
+    _mm256_storeu_si256((__m256i*)lane_idx, vidx);
+
+    int max_idx = spectrum_peak_scalar(bins, first + count, end, peak_sq);
+    if (*peak_sq == 0) max_idx = first;
+    return reduce_lanes(lane_max, lane_idx, 8, max_idx, peak_sq);
+}
+
+#endif
+
+static SpectrumPeakFn peak_kernel = spectrum_peak_scalar;
+static const char* peak_kernel_name = "scalar";
+static pthread_once_t peak_kernel_once = PTHREAD_ONCE_INIT;
+
+static void select_peak_kernel(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        peak_kernel = spectrum_peak_avx2;
+        peak_kernel_name = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        peak_kernel = spectrum_peak_sse2;
+        peak_kernel_name = "sse2";
+    }
+#endif
+}
+
+int spectrum_peak(const kiss_fft_cpx* bins, int first, int end, float* peak_sq) {
+    pthread_once(&peak_kernel_once, select_peak_kernel);
+    return peak_kernel(bins, first, end, peak_sq);
+}
+
+const char* spectrum_peak_kernel_name(void) {
+    pthread_once(&peak_kernel_once, select_peak_kernel);
+    return peak_kernel_name;
+}
@@ -0,0 +1,22 @@
+#ifndef PICO_ESPECTRAL_H
+#define PICO_ESPECTRAL_H
+
+#include "kiss_fft.h"
+
+// Finds the bin with the largest magnitude in bins[first..end) and stores its squared
+// magnitude in *peak_sq. Compares r*r + i*i, so no sqrt runs per bin; ties keep the
+// lowest bin, like a scalar `mag > max_mag` scan. Returns first if every bin is zero.
+typedef int (*SpectrumPeakFn)(const kiss_fft_cpx* bins, int first, int end, float* peak_sq);
+
+int spectrum_peak_scalar(const kiss_fft_cpx* bins, int first, int end, float* peak_sq);
+#if defined(__x86_64__) || defined(__i386__)
+int spectrum_peak_sse2(const kiss_fft_cpx* bins, int first, int end, float* peak_sq);
+int spectrum_peak_avx2(const kiss_fft_cpx* bins, int first, int end, float* peak_sq);
+#endif
+
+// Best kernel for the running CPU (AVX2, SSE2 or scalar), chosen on the first call.
+// The same binary runs on the DE2i-150's Atom (SSE2 only) and on AVX2 machines.
+int spectrum_peak(const kiss_fft_cpx* bins, int first, int end, float* peak_sq);
+const char* spectrum_peak_kernel_name(void);
+
+#endif // PICO_ESPECTRAL_H
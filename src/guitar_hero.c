@@ -1,8 +1,9 @@
 #include "guitar_hero.h"
+#include "mapeamento_audio.h"
 
 struct termios orig_termios;
 
-int main() {
+int main(int argc, char **argv) {
     enableRawMode();
     init_terminal();
 
@@ -18,12 +19,23 @@ int main() {
 
     GameState game_state;
     memset(&game_state, 0, sizeof(GameState));
+    const char *arquivo_musica = "musica_sweet.mp3";
+    if (argc > 1 && atof(argv[1]) > 0) {
+        game_state.inicio_musica = atof(argv[1]);
+    }
     
-    carregar_nivel(&game_state);
+    // Sem mapa pronto, gera o nível enquanto a música toca em vez de esperar a análise inteira
+    if (access(LEVEL_COMPILED_FILENAME, F_OK) != 0 && access(LEVEL_FILENAME, F_OK) != 0) {
+        if (iniciar_nivel_progressivo(&game_state, arquivo_musica) != 0) {
+            printf("Não foi possível iniciar a análise de '%s'.\n", arquivo_musica);
+            return -1;
+        }
+    } else {
+        carregar_nivel(&game_state);
+    }
     inicializar_jogo(&game_state);
     game_state.joy_fd = init_joystick(&game_state);
 
-    const char *arquivo_musica = "musica_sweet.mp3";
     game_state.musica = Mix_LoadMUS(arquivo_musica);
     if (game_state.musica == NULL) {
         printf("Não foi possível carregar a música '%s': %s\n", arquivo_musica, Mix_GetError());
@@ -40,8 +52,28 @@ int main() {
     }
     printf("\nJOGUE!\n");
 
+    if (game_state.mapa_progressivo) {
+        // A contagem já deu tempo de sobra; só espera se a análise ainda não cobriu a antevisão.
+        // Se a análise já está parada no limite de adiantamento, esperar mais não a faz andar
+        int alvo_ms = (int)((game_state.inicio_musica + TEMPO_DE_ANTEVISAO) * 1000);
+        int limite_ms = (int)(ADIANTAMENTO_DA_ANALISE * 1000);
+        while (!atomic_load(&game_state.analise_concluida) &&
+               atomic_load(&game_state.horizonte_ms) < alvo_ms &&
+               atomic_load(&game_state.horizonte_ms) - atomic_load(&game_state.tempo_de_jogo_ms) <= limite_ms) {
+            SDL_Delay(10);
+        }
+        sincronizar_nivel_progressivo(&game_state);
+        if (game_state.note_count > 0) {
+            printf("Mapa progressivo: primeira nota em %u ms, %d notas prontas\n",
+                   game_state.primeira_nota_ms, game_state.note_count);
+        }
+    }
+
     // Inicia música e marca o tempo exato de início
     Mix_PlayMusic(game_state.musica, 1);
+    if (game_state.inicio_musica > 0 && Mix_SetMusicPosition(game_state.inicio_musica) != 0) {
+        printf("Não foi possível avançar a música para %.2f s: %s\n", game_state.inicio_musica, Mix_GetError());
+    }
     game_state.musica_playing = 1;
     game_state.start_time = SDL_GetTicks();
     
@@ -49,12 +81,24 @@ int main() {
     SDL_Delay(50);
 
     float tempo_final_do_nivel = game_state.note_count > 0 ? 
-        game_state.level_notes[game_state.note_count - 1].timestamp + 2.0f : 5.0f;
+        game_state.level_notes.timestamps[game_state.note_count - 1] + 2.0f : 5.0f;
 
     // Loop principal do jogo
     while (!game_state.game_over && game_state.musica_playing) {
         Uint32 frame_start = SDL_GetTicks();
-        double tempo_decorrido = (double)(frame_start - game_state.start_time) / 1000.0;
+        double tempo_decorrido = game_state.inicio_musica + (double)(frame_start - game_state.start_time) / 1000.0;
+
+        if (game_state.mapa_progressivo) {
+            atomic_store(&game_state.tempo_de_jogo_ms, (int)(tempo_decorrido * 1000));
+            int concluida = atomic_load(&game_state.analise_concluida);
+            sincronizar_nivel_progressivo(&game_state);
+            // O fim do nível só é conhecido quando a análise termina
+            if (!concluida) {
+                tempo_final_do_nivel = tempo_decorrido + 1.0f;
+            } else if (game_state.note_count > 0) {
+                tempo_final_do_nivel = game_state.level_notes.timestamps[game_state.note_count - 1] + 2.0f;
+            }
+        }
 
         // Só processa inputs e notas após 0.5s para sincronizar com a música
         if (tempo_decorrido > 0.5f) {
@@ -130,6 +174,14 @@ int kbhit(void) {
     return select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv) > 0;
 }
 
+// Põe a nota i na fila da sua pista, onde check_hits a encontra
+static void enfileirar_nota(GameState *state, int i) {
+    int pista = state->level_notes.lanes[i];
+    if (lane_queues_push(&state->filas, pista, state->level_notes.timestamps[i], i) != 0) {
+        printf("Erro ao alocar memoria para a fila da pista %d.\n", pista + 1);
+    }
+}
+
 void inicializar_jogo(GameState *state) {
     state->score = 0;
     state->combo = 1;
@@ -137,45 +189,61 @@ void inicializar_jogo(GameState *state) {
     state->game_over = 0;
     state->musica_playing = 0;
     
+    // Notas antes do ponto de partida não contam como erro
+    lane_queues_clear(&state->filas);
+    state->fronteira_de_erros = 0;
+    LevelNotes *notas = &state->level_notes;
     for (int i = 0; i < state->note_count; i++) {
-        state->level_notes[i].foi_processada = 0;
-        state->level_notes[i].foi_pressionada = 0;
+        level_note_clear(notas->pressed, i);
+        if (notas->timestamps[i] < state->inicio_musica) {
+            level_note_set(notas->processed, i);
+        } else {
+            level_note_clear(notas->processed, i);
+            enfileirar_nota(state, i);
+        }
     }
 }
 
-void carregar_nivel(GameState *state) {
-    FILE *file = fopen(LEVEL_FILENAME, "r");
-    if (!file) {
-        perror("Não foi possível abrir o arquivo de nível");
-        exit(1);
+// Copia as notas do mapa compilado (notes.ghc), já ordenadas e com a pista calculada
+// pelo criador_mapa, sem nenhum parsing. Retorna -1 se o arquivo não existir ou for inválido.
+int carregar_nivel_compilado(GameState *state, const char *arquivo) {
+    int total = level_notes_load_compiled(&state->level_notes, arquivo);
+    if (total < 0) return -1;
+    state->note_count = total;
+    return 0;
+}
+
+// Primeira nota com timestamp >= tempo, por busca binária nas notas em ordem de tempo
+static int primeira_nota_a_partir_de(const GameState *state, double tempo) {
+    int inicio = 0, fim = state->note_count;
+    while (inicio < fim) {
+        int meio = inicio + (fim - inicio) / 2;
+        if (state->level_notes.timestamps[meio] < tempo) {
+            inicio = meio + 1;
+        } else {
+            fim = meio;
+        }
     }
+    return inicio;
+}
 
-    state->note_count = 0;
-    float timestamp;
-    char note_name[5];
-    
-    while (fscanf(file, "%f %s", &timestamp, note_name) == 2) {
-        if (state->note_count < MAX_NOTES) {
-            int pista_mapeada = -1;
-
-            switch (note_name[0]) {
-                case 'C': case 'D': pista_mapeada = 0; break;
-                case 'E': case 'F': pista_mapeada = 1; break;
-                case 'G': case 'A': pista_mapeada = 2; break;
-                case 'B': pista_mapeada = 3; break;
-            }
+void carregar_nivel(GameState *state) {
+    // Usa o mapa compilado se ele não for mais antigo que o notes.txt (que pode ter sido editado)
+    struct stat st_texto, st_compilado;
+    int tem_texto = stat(LEVEL_FILENAME, &st_texto) == 0;
+    if (stat(LEVEL_COMPILED_FILENAME, &st_compilado) == 0 &&
+        (!tem_texto || st_compilado.st_mtime >= st_texto.st_mtime) &&
+        carregar_nivel_compilado(state, LEVEL_COMPILED_FILENAME) == 0) {
+        return;
+    }
 
-            if (pista_mapeada != -1) {
-                state->level_notes[state->note_count].timestamp = timestamp;
-                strcpy(state->level_notes[state->note_count].note_name, note_name);
-                state->level_notes[state->note_count].note_index = pista_mapeada;
-                state->level_notes[state->note_count].foi_processada = 0;
-                state->level_notes[state->note_count].foi_pressionada = 0;
-                state->note_count++;
-            }
-        }
+    // Sem limite de notas: o arquivo é mapeado e lido uma vez, direto para os arrays; linhas inválidas saem com o número
+    int total = level_notes_load_text(&state->level_notes, LEVEL_FILENAME);
+    if (total < 0) {
+        perror("Não foi possível abrir o arquivo de nível");
+        exit(1);
     }
-    fclose(file);
+    state->note_count = total;
 }
 
 void process_input(GameState *state, double tempo_decorrido) {
@@ -208,25 +276,17 @@ void check_joystick_input(GameState *state, double tempo_decorrido) {
 }
 
 void check_hits(GameState *state, int pista, double tempo_decorrido) {
-    int hit = 0;
-    
-    for (int i = 0; i < state->note_count; i++) {
-        if (state->level_notes[i].foi_processada) continue;
-        
-        float timestamp_nota = state->level_notes[i].timestamp;
-        int pista_nota = state->level_notes[i].note_index;
-        
-        if ((pista == pista_nota) && 
-            (tempo_decorrido > timestamp_nota - 0.2 && tempo_decorrido < timestamp_nota + 0.2)) {
-            printf("\a");
-            state->score += 10 * state->combo;
-            state->combo++;
-            state->consecutive_misses = 0;
-            state->level_notes[i].foi_processada = 1;
-            state->level_notes[i].foi_pressionada = 1;
-            hit = 1;
-            break;
-        }
+    // Botões 1..4 são as pistas 0..3; só a primeira nota ainda julgável da pista é olhada
+    int i = lane_queues_hit(&state->filas, pista - 1, tempo_decorrido, JANELA_DE_ACERTO);
+    int hit = i >= 0;
+
+    if (hit) {
+        printf("\a");
+        state->score += 10 * state->combo;
+        state->combo++;
+        state->consecutive_misses = 0;
+        level_note_set(state->level_notes.processed, i);
+        level_note_set(state->level_notes.pressed, i);
     }
     
     if (!hit && pista != 0) {
@@ -242,22 +302,19 @@ void check_hits(GameState *state, int pista, double tempo_decorrido) {
 }
 
 void update_game(GameState *state, double tempo_decorrido) {
-    for (int i = 0; i < state->note_count; i++) {
-        if (!state->level_notes[i].foi_processada && 
-            tempo_decorrido > state->level_notes[i].timestamp + 0.2) {
-            
-            state->level_notes[i].foi_processada = 1;
-            
-            if (!state->level_notes[i].foi_pressionada) {
-                state->consecutive_misses++;
-                state->combo = 1;
-                
-                if (state->consecutive_misses >= MAX_MISSES) {
-                    state->game_over = 1;
-                    Mix_HaltMusic();
-                    state->musica_playing = 0;
-                }
-            }
+    // Notas em ordem de tempo: só as que saíram da janela de acerto desde o último frame são olhadas,
+    // 8 por vez. Nota acertada já está processada, então toda nota que expira sem estar processada é erro
+    int erros;
+    state->fronteira_de_erros = level_notes_expire(&state->level_notes, state->fronteira_de_erros, state->note_count,
+                                                   tempo_decorrido, JANELA_DE_ACERTO, &erros);
+    if (erros > 0) {
+        state->consecutive_misses += erros;
+        state->combo = 1;
+        
+        if (state->consecutive_misses >= MAX_MISSES) {
+            state->game_over = 1;
+            Mix_HaltMusic();
+            state->musica_playing = 0;
         }
     }
 }
@@ -273,17 +330,18 @@ void render_game(GameState *state, double tempo_decorrido) {
     // Ajuste para mostrar notas apenas após 0.5s
     double tempo_ajustado = tempo_decorrido > 0.5f ? tempo_decorrido - 0.5f : 0;
 
-    for (int i = 0; i < state->note_count; i++) {
-        if (!state->level_notes[i].foi_processada) {
-            float tempo_da_nota = state->level_notes[i].timestamp;
-            float dist_temporal = tempo_da_nota - tempo_ajustado;
-
-            if (dist_temporal >= 0 && dist_temporal < TEMPO_DE_ANTEVISAO) {
-                int linha = ALTURA_DA_PISTA - 1 - (int)((dist_temporal / TEMPO_DE_ANTEVISAO) * ALTURA_DA_PISTA);
-                if (linha >= 0 && linha < ALTURA_DA_PISTA) {
-                    int pista_da_nota = state->level_notes[i].note_index;
-                    pista_visual[linha][pista_da_nota] = (pista_da_nota + 1) + '0';
-                }
+    // Só as notas da antevisão: da primeira que ainda não passou até a que sai da tela
+    const LevelNotes *notas = &state->level_notes;
+    for (int i = primeira_nota_a_partir_de(state, tempo_ajustado); i < state->note_count; i++) {
+        float tempo_da_nota = notas->timestamps[i];
+        float dist_temporal = tempo_da_nota - tempo_ajustado;
+        if (dist_temporal >= TEMPO_DE_ANTEVISAO) break;
+
+        if (!level_note_bit(notas->processed, i)) {
+            int linha = ALTURA_DA_PISTA - 1 - (int)((dist_temporal / TEMPO_DE_ANTEVISAO) * ALTURA_DA_PISTA);
+            if (linha >= 0 && linha < ALTURA_DA_PISTA) {
+                int pista_da_nota = notas->lanes[i];
+                pista_visual[linha][pista_da_nota] = (pista_da_nota + 1) + '0';
             }
         }
     }
@@ -329,10 +387,136 @@ void finalizar_jogo(GameState *state) {
     if (state->musica_playing) {
         Mix_HaltMusic();
     }
+    finalizar_nivel_progressivo(state);
+    lane_queues_free(&state->filas);
+    level_notes_free(&state->level_notes);
     printf("\nFim de jogo! Pontuação Final: %d\n", state->score);
     if (state->joy_fd != -1) close(state->joy_fd);
     if (state->musica != NULL) Mix_FreeMusic(state->musica);
     Mix_Quit();
     SDL_Quit();
     disableRawMode();
+}
+
+/***********************************************
+ *           MAPA PROGRESSIVO
+ ***********************************************/
+
+// Roda na thread de análise: a nota é escrita antes de o total ser publicado (release),
+// então o jogo, lendo o total com acquire, nunca vê uma nota pela metade
+static void nota_analisada(void *user, double tempo, int nota) {
+    GameState *state = (GameState *)user;
+    int n = atomic_load_explicit(&state->notas_publicadas, memory_order_relaxed);
+    if (n >= state->level_notes.capacity) {
+        state->notas_descartadas++;
+        return;
+    }
+
+    // Os bits da nota já estão zerados desde a alocação; só o jogo escreve neles
+    state->level_notes.timestamps[n] = (float)tempo;
+    state->level_notes.lanes[n] = chart_lane_for_note(nota);
+    if (n == 0) state->primeira_nota_ms = SDL_GetTicks() - state->inicio_analise_ms;
+    atomic_store_explicit(&state->notas_publicadas, n + 1, memory_order_release);
+}
+
+// A análise é muito mais rápida que a música: segura a thread quando ela está
+// ADIANTAMENTO_DA_ANALISE à frente, para não disputar a CPU com o jogo. Com o jogo
+// saindo, para a análise ali mesmo em vez de deixá-la terminar a música
+static int progresso_da_analise(void *user, double tempo_analisado) {
+    GameState *state = (GameState *)user;
+    int horizonte = (int)(tempo_analisado * 1000);
+    atomic_store_explicit(&state->horizonte_ms, horizonte, memory_order_release);
+    while (!atomic_load(&state->cancelar_analise) &&
+           horizonte - atomic_load(&state->tempo_de_jogo_ms) > (int)(ADIANTAMENTO_DA_ANALISE * 1000)) {
+        SDL_Delay(5);
+    }
+    return atomic_load(&state->cancelar_analise);
+}
+
+static void *thread_de_analise(void *arg) {
+    GameState *state = (GameState *)arg;
+    AnalysisOptions options = ANALYSIS_OPTIONS_DEFAULT;
+    options.mode = ANALYSIS_STREAMING;
+    options.start_seconds = state->inicio_musica;
+    NoteSink sink = { nota_analisada, progresso_da_analise, state };
+
+    // Começando do início, também grava o notes.txt, para a próxima partida carregar o mapa
+    // direto; de outro ponto, o índice de frames leva a análise até lá e o mapa fica parcial.
+    // O arquivo só ganha o nome final com a análise completa: se o jogo sair, for morto ou
+    // cair no meio, fica no máximo um .tmp, e a próxima partida gera o mapa de novo
+    const char *saida = state->inicio_musica > 0 ? NULL : LEVEL_TEMP_FILENAME;
+    int resultado = analyze_mp3_stream(state->arquivo_analisado, saida, &options, &sink);
+    if (saida) {
+        if (resultado == 0) {   // 1: parada por cancelar_analise, mapa incompleto
+            rename(saida, LEVEL_FILENAME);
+        } else {
+            remove(saida);
+        }
+    }
+    atomic_store(&state->analise_concluida, 1);
+    return NULL;
+}
+
+// Teto de notas da análise progressiva: no máximo uma por janela de FRAME_SIZE amostras,
+// contando as amostras pelos cabeçalhos dos frames do MP3, sem decodificar. A tag VBR é
+// ignorada: uma tag que conta frames de menos faria o teto cortar o fim da música
+static int notas_possiveis(const char *arquivo_musica) {
+    int fd = open(arquivo_musica, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    void *mp3 = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        mp3 = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (mp3 == MAP_FAILED) return -1;
+
+    size_t amostras = count_pcm_samples((const unsigned char *)mp3, st.st_size);
+    munmap(mp3, st.st_size);
+    return (int)(amostras / FRAME_SIZE) + 1;
+}
+
+int iniciar_nivel_progressivo(GameState *state, const char *arquivo_musica) {
+    // A thread escreve nas notas enquanto o jogo lê: o espaço é todo reservado antes
+    int teto = notas_possiveis(arquivo_musica);
+    if (teto < 0 || level_notes_alloc(&state->level_notes, teto) != 0) {
+        return -1;
+    }
+    state->mapa_progressivo = 1;
+    state->arquivo_analisado = arquivo_musica;
+    state->inicio_analise_ms = SDL_GetTicks();
+    state->note_count = 0;
+    atomic_init(&state->notas_publicadas, 0);
+    atomic_init(&state->horizonte_ms, 0);
+    atomic_init(&state->analise_concluida, 0);
+    // A análise se adianta em relação a esta posição: com ./jogo 60 ela precisa correr até
+    // os 60 s antes de a partida começar, e não parar 8 s depois do início da música
+    atomic_init(&state->tempo_de_jogo_ms, (int)(state->inicio_musica * 1000));
+    atomic_init(&state->cancelar_analise, 0);
+    state->notas_descartadas = 0;
+
+    printf("Mapa '%s' não encontrado: gerando as notas durante a música.\n", LEVEL_FILENAME);
+    if (pthread_create(&state->thread_analise, NULL, thread_de_analise, state) != 0) {
+        state->mapa_progressivo = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void sincronizar_nivel_progressivo(GameState *state) {
+    int publicadas = atomic_load_explicit(&state->notas_publicadas, memory_order_acquire);
+    for (int i = state->note_count; i < publicadas; i++) {
+        enfileirar_nota(state, i);
+    }
+    state->note_count = publicadas;
+}
+
+void finalizar_nivel_progressivo(GameState *state) {
+    if (!state->mapa_progressivo) return;
+    atomic_store(&state->cancelar_analise, 1);
+    pthread_join(state->thread_analise, NULL);
+    state->mapa_progressivo = 0;
+    if (state->notas_descartadas > 0) {
+        printf("Aviso: %d notas da análise não couberam no mapa progressivo.\n", state->notas_descartadas);
+    }
 }
\ No newline at end of file
@@ -12,15 +12,26 @@
 #include <SDL2/SDL_mixer.h>
 #include <fcntl.h>
 #include <linux/joystick.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "mapa_compilado.h"
+#include "fila_pistas.h"
+#include "notas_nivel.h"
 
-#define MAX_NOTES 2000
 #define LEVEL_FILENAME "notes.txt"
+#define LEVEL_TEMP_FILENAME LEVEL_FILENAME ".tmp"   // mapa progressivo em escrita, renomeado no fim
+#define LEVEL_COMPILED_FILENAME "notes.ghc"
 #define TARGET_FPS 60
 #define FRAME_DELAY (1000 / TARGET_FPS)
 #define ALTURA_DA_PISTA 20
 #define TEMPO_DE_ANTEVISAO 3.0f
 #define MAX_MISSES 3
+#define JANELA_DE_ACERTO 0.2      // s antes e depois da nota em que um toque ainda acerta
 #define AUDIO_BUFFER_SIZE 1024
+// Mapa progressivo: a análise pausa quando está este tanto à frente da música
+#define ADIANTAMENTO_DA_ANALISE (TEMPO_DE_ANTEVISAO + 5.0f)
 
 // Cores ANSI para cada pista
 #define COLOR_GREEN "\033[32m"
@@ -30,16 +41,10 @@
 #define COLOR_RESET "\033[0m"
 
 typedef struct {
-    float timestamp;
-    char note_name[5];
-    int note_index;
-    int foi_processada;
-    int foi_pressionada;
-} GameNote;
-
-typedef struct {
-    GameNote level_notes[MAX_NOTES];
+    LevelNotes level_notes;        // alocado no tamanho do mapa (ou do teto da análise progressiva)
     int note_count;
+    LaneQueues filas;              // notas de cada pista ainda não julgadas, em ordem de tempo
+    int fronteira_de_erros;        // update_game já julgou todas as notas antes desta
     int score;
     int combo;
     int consecutive_misses;
@@ -48,6 +53,22 @@ typedef struct {
     int game_over;
     Mix_Music *musica;
     int musica_playing;
+    double inicio_musica;          // posição (s) em que a partida começa: ./jogo [segundos]
+
+    // Mapa progressivo: uma thread de análise acrescenta notas em level_notes enquanto
+    // a música toca. Ela escreve a nota e só depois publica o novo total; o jogo copia o
+    // total publicado para note_count a cada frame e só lê esse prefixo.
+    int mapa_progressivo;
+    pthread_t thread_analise;
+    const char *arquivo_analisado;
+    Uint32 inicio_analise_ms;
+    Uint32 primeira_nota_ms;       // escrito antes de publicar a primeira nota
+    atomic_int notas_publicadas;
+    atomic_int horizonte_ms;       // todas as notas antes deste tempo já foram publicadas
+    atomic_int analise_concluida;
+    atomic_int tempo_de_jogo_ms;   // posição da música, para a análise não se adiantar demais
+    atomic_int cancelar_analise;
+    int notas_descartadas;         // só a thread de análise escreve; lido depois do join
 } GameState;
 
 /***********************************************
@@ -62,6 +83,7 @@ int kbhit(void);
 
 // Funções do jogo
 void carregar_nivel(GameState *state);
+int carregar_nivel_compilado(GameState *state, const char *arquivo);
 void inicializar_jogo(GameState *state);
 void process_input(GameState *state, double tempo_decorrido);
 void check_joystick_input(GameState *state, double tempo_decorrido);
@@ -70,5 +92,10 @@ void update_game(GameState *state, double tempo_decorrido);
 void render_game(GameState *state, double tempo_decorrido);
 void finalizar_jogo(GameState *state);
 
+// Mapa progressivo
+int iniciar_nivel_progressivo(GameState *state, const char *arquivo_musica);
+void sincronizar_nivel_progressivo(GameState *state);
+void finalizar_nivel_progressivo(GameState *state);
+
 
 #endif
\ No newline at end of file
@@ -6,6 +6,8 @@
 
 #include "guitar_hero.h"
 #include "ioctl_cmds.h"
+#include "cache_mapas.h"
+#include "notas_nivel.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -39,7 +41,6 @@
 
 // Constantes do jogo
 #define LEVEL_FILENAME "level_data.txt"
-#define MAX_NOTES 5000
 #define MAX_MISSES 3
 #define FRAME_DELAY 10 // Aprox. 100 FPS
 #define ALTURA_DA_PISTA 10
@@ -53,14 +54,6 @@
 #define COLOR_RESET "\033[0m"
 
 // Estruturas do jogo
-typedef struct {
-    float timestamp;
-    char note_name[5];
-    int note_index;
-    int foi_processada;
-    int foi_pressionada;
-} Note;
-
 typedef struct {
     int score;
     int combo;
@@ -69,7 +62,7 @@ typedef struct {
     Uint32 start_time;
     int musica_playing;
     Mix_Music *musica;
-    Note level_notes[MAX_NOTES];
+    LevelNotes level_notes;  // tempos, pistas e bits de cada nota, no tamanho exato do mapa
     int note_count;
     int joy_fd;
     int fd_pbuttons;
@@ -258,8 +251,8 @@ void inicializar_jogo(GameState *state) {
     state->musica_playing = 0;
     
     for (int i = 0; i < state->note_count; i++) {
-        state->level_notes[i].foi_processada = 0;
-        state->level_notes[i].foi_pressionada = 0;
+        level_note_clear(state->level_notes.processed, i);
+        level_note_clear(state->level_notes.pressed, i);
     }
 
     state->joy_fd = -1;
@@ -267,44 +260,23 @@ void inicializar_jogo(GameState *state) {
 }
 
 void carregar_nivel(GameState *state) {
-    FILE *file = fopen(LEVEL_FILENAME, "r");
-    if (!file) {
+    // Sem limite de notas: o arquivo é mapeado e lido uma vez, direto para os arrays; linhas inválidas saem com o número
+    int total = level_notes_load_text(&state->level_notes, LEVEL_FILENAME);
+    if (total < 0) {
         perror("Não foi possível abrir o arquivo de nível");
         exit(1);
     }
-    state->note_count = 0;
-    float timestamp;
-    char note_name[5];
-    
-    while (fscanf(file, "%f %s", &timestamp, note_name) == 2) {
-        if (state->note_count < MAX_NOTES) {
-            int pista_mapeada = -1;
-            switch (note_name[0]) {
-                case 'C': case 'D': pista_mapeada = 0; break;
-                case 'E': case 'F': pista_mapeada = 1; break;
-                case 'G': case 'A': pista_mapeada = 2; break;
-                case 'B': pista_mapeada = 3; break;
-            }
-            if (pista_mapeada != -1) {
-                state->level_notes[state->note_count].timestamp = timestamp;
-                strcpy(state->level_notes[state->note_count].note_name, note_name);
-                state->level_notes[state->note_count].note_index = pista_mapeada;
-                state->level_notes[state->note_count].foi_processada = 0;
-                state->level_notes[state->note_count].foi_pressionada = 0;
-                state->note_count++;
-            }
-        }
-    }
-    fclose(file);
+    state->note_count = total;
 }
 
 void check_hits(GameState *state, int pista, double tempo_decorrido) {
     int hit = 0;
 
+    LevelNotes *notas = &state->level_notes;
     for (int i = 0; i < state->note_count; i++) {
-        if (state->level_notes[i].foi_processada) continue;
-        float timestamp_nota = state->level_notes[i].timestamp;
-        int pista_nota = state->level_notes[i].note_index;
+        if (level_note_bit(notas->processed, i)) continue;
+        float timestamp_nota = notas->timestamps[i];
+        int pista_nota = notas->lanes[i];
 
         if ((pista == pista_nota + 1) && 
             (tempo_decorrido > timestamp_nota - 0.15 && 
@@ -313,8 +285,8 @@ void check_hits(GameState *state, int pista, double tempo_decorrido) {
             state->score += 10 * state->combo;
             state->combo++;
             state->consecutive_misses = 0;
-            state->level_notes[i].foi_processada = 1;
-            state->level_notes[i].foi_pressionada = 1;
+            level_note_set(notas->processed, i);
+            level_note_set(notas->pressed, i);
             hit = 1;
             flash_led(state->fd_hardware, 1); // Acende LED verde
             break;
@@ -369,11 +341,12 @@ void process_input(GameState *state, double tempo_decorrido) {
 }
 
 void update_game(GameState *state, double tempo_decorrido) {
+    LevelNotes *notas = &state->level_notes;
     for (int i = 0; i < state->note_count; i++) {
-        if (!state->level_notes[i].foi_processada && 
-            tempo_decorrido > state->level_notes[i].timestamp + 0.15) {
-            state->level_notes[i].foi_processada = 1;
-            if (!state->level_notes[i].foi_pressionada) {
+        if (!level_note_bit(notas->processed, i) && 
+            tempo_decorrido > notas->timestamps[i] + 0.15) {
+            level_note_set(notas->processed, i);
+            if (!level_note_bit(notas->pressed, i)) {
                 state->consecutive_misses++;
                 state->combo = 1;
                 flash_led(state->fd_hardware, 0); // LED vermelho (erro por não apertar a tempo)
@@ -397,14 +370,15 @@ void render_game(GameState *state, double tempo_decorrido) {
         sprintf(pista_visual[i], "    ");
     }
     double tempo_ajustado = tempo_decorrido > 0.5f ? tempo_decorrido - 0.5f : 0;
+    const LevelNotes *notas = &state->level_notes;
     for (int i = 0; i < state->note_count; i++) {
-        if (!state->level_notes[i].foi_processada) {
-            float tempo_da_nota = state->level_notes[i].timestamp;
+        if (!level_note_bit(notas->processed, i)) {
+            float tempo_da_nota = notas->timestamps[i];
             float dist_temporal = tempo_da_nota - tempo_ajustado;
             if (dist_temporal >= 0 && dist_temporal < TEMPO_DE_ANTEVISAO) {
                 int linha = ALTURA_DA_PISTA - 1 - (int)((dist_temporal / TEMPO_DE_ANTEVISAO) * ALTURA_DA_PISTA);
                 if (linha >= 0 && linha < ALTURA_DA_PISTA) {
-                    int pista_da_nota = state->level_notes[i].note_index;
+                    int pista_da_nota = notas->lanes[i];
                     pista_visual[linha][pista_da_nota] = (pista_da_nota + 1) + '0';
                 }
             }
@@ -451,6 +425,7 @@ void finalizar_jogo(GameState *state) {
     close_hardware(state->fd_hardware);
     if (state->joy_fd != -1) close(state->joy_fd);
     if (state->musica != NULL) Mix_FreeMusic(state->musica);
+    level_notes_free(&state->level_notes);
     Mix_CloseAudio();
     SDL_Quit();
     disableRawMode();
@@ -516,14 +491,31 @@ int main() {
     }
 
     const char *arquivo_musica = "musica_sweet.mp3";
-    AudioData *audio_data = load_mp3_file(arquivo_musica);
-    if (!audio_data) {
-        fprintf(stderr, "Erro ao carregar áudio para análise!\n");
-        finalizar_jogo(&game_state);
-        return -1;
+
+    // Cache de mapas: se esta música já foi analisada com os mesmos parâmetros,
+    // pula a decodificação e a FFT e vai direto para o carregar_nivel
+    Uint32 inicio_mapa = SDL_GetTicks();
+    char chave[CHART_CACHE_KEY_SIZE];
+    double tempo_analise = 0;
+    int tem_chave = chart_cache_key(arquivo_musica, NULL, chave) == 0;
+    if (tem_chave && chart_cache_fetch(chave, LEVEL_FILENAME, &tempo_analise) == 0) {
+        double tempo_cache = (SDL_GetTicks() - inicio_mapa) / 1000.0;
+        printf("Cache de mapas: acerto (%s), mapa carregado em %.3f s, %.3f s economizados\n",
+               chave, tempo_cache, tempo_analise - tempo_cache);
+    } else {
+        printf("Cache de mapas: falha (%s), analisando '%s'...\n", tem_chave ? chave : "sem chave", arquivo_musica);
+        AudioData *audio_data = load_mp3_file(arquivo_musica);
+        if (!audio_data) {
+            fprintf(stderr, "Erro ao carregar áudio para análise!\n");
+            finalizar_jogo(&game_state);
+            return -1;
+        }
+        analyze_audio_to_file(audio_data, LEVEL_FILENAME);
+        free_audio_data(audio_data);
+        tempo_analise = (SDL_GetTicks() - inicio_mapa) / 1000.0;
+        printf("Cache de mapas: análise levou %.3f s\n", tempo_analise);
+        if (tem_chave) chart_cache_store(chave, LEVEL_FILENAME, tempo_analise);
     }
-    analyze_audio_to_file(audio_data, LEVEL_FILENAME);
-    free_audio_data(audio_data);
 
     carregar_nivel(&game_state);
     inicializar_jogo(&game_state);
@@ -555,7 +547,7 @@ int main() {
     game_state.start_time = SDL_GetTicks();
     SDL_Delay(50);
     float tempo_final_do_nivel = game_state.note_count > 0 ? 
-        game_state.level_notes[game_state.note_count - 1].timestamp + 2.0f : 5.0f;
+        game_state.level_notes.timestamps[game_state.note_count - 1] + 2.0f : 5.0f;
 
     while (!game_state.game_over && game_state.musica_playing) {
         Uint32 frame_start = SDL_GetTicks();